@@ -30,9 +30,9 @@ Dialog {
 
     property bool createNewEntry: false
     // ID of the keepass entry to be edited
-    property string entryId: ""
+    property int entryId: 0
     // creation of new entry needs parent group ID
-    property string parentGroupId: ""
+    property int parentGroupId: 0
 
     // The following properties are used to check if text of any entry detail was changed. If so,
     // set cover page accordingly to signal the user unsaved changes
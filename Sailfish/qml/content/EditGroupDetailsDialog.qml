@@ -30,9 +30,9 @@ Dialog {
 
     property bool createNewGroup: false
     // ID of the keepass entry which should be edited
-    property string groupId: ""
+    property int groupId: 0
     // creation of new group needs parent group ID
-    property string parentGroupId: ""
+    property int parentGroupId: 0
 
     // The following properties are used to check if text of any entry detail was changed. If so,
     // set cover page accordingly to signal the user unsaved changes
@@ -35,7 +35,7 @@ Page {
     // be opened successfully with the master password.
     property bool initOnPageConstruction: true
     // ID of the keepass group which should be shown ("0" for master groups)
-    property string groupId: "0"
+    property int groupId: 0
     property string pageTitle: qsTr("Password groups")
 
     // private properties and funtions
@@ -56,7 +56,7 @@ Page {
         // "Loading" state is initially active when database is currently opening from QueryPasswordDialog.
         // Depending how long it takes to calculate the master key by doing keyTransfomationRounds the init
         // function is called with a significant delay. During that time the busy indicator is shown.
-        if (groupId === "0") {
+        if (groupId === 0) {
             kdbListModel.loadMasterGroupsFromDatabase()
         } else {
             kdbListModel.loadGroupsAndEntriesFromDatabase(groupId)
@@ -207,7 +207,7 @@ Page {
             text: qsTr("Group is empty")
             hintText: !ownKeepassDatabase.readOnly ?
                           (ownKeepassDatabase.type === DatabaseType.DB_TYPE_KEEPASS_1 &&
-                          groupId === "0" ? qsTr("Pull down to add password groups") :
+                          groupId === 0 ? qsTr("Pull down to add password groups") :
                                           qsTr("Pull down to add password groups or entries")) : ""
 
             Image {
@@ -261,7 +261,7 @@ Page {
         }
 
         ApplicationMenu {
-            helpContent: groupId === "0" ? "MasterGroupsPage" : "SubGroupsPage"
+            helpContent: groupId === 0 ? "MasterGroupsPage" : "SubGroupsPage"
         }
 
         VerticalScrollDecorator {}
@@ -311,17 +311,17 @@ Page {
             name: "SEARCH_BAR_HIDDEN"
             PropertyChanges { target: databaseMenu; enableDatabaseSettingsMenuItem: true
                 enableNewPasswordGroupsMenuItem: true
-                enableNewPasswordEntryMenuItem: groupId !== "0"
+                enableNewPasswordEntryMenuItem: groupId !== 0
                 enableSearchMenuItem: !kdbListModel.isEmpty; isTextHideSearch: false }
             PropertyChanges { target: viewPlaceholder; enabled: kdbListModel.isEmpty }
             PropertyChanges { target: searchNoEntriesFoundPlaceholder; enabled: false }
             PropertyChanges { target: busyIndicator; running: false }
             PropertyChanges { target: pageHeader
-                title: groupId === "0" ? qsTr("Password groups") :
+                title: groupId === 0 ? qsTr("Password groups") :
                                        groupsAndEntriesPage.pageTitle }
             PropertyChanges { target: searchField; enabled: false }
             PropertyChanges { target: applicationWindow.cover
-                title: groupId === "0" ? qsTr("Password groups") :
+                title: groupId === 0 ? qsTr("Password groups") :
                                        groupsAndEntriesPage.pageTitle
                 state: "GROUPS_VIEW" }
 
@@ -331,18 +331,18 @@ Page {
             name: "SEARCH_BAR_SHOWN"
             PropertyChanges { target: databaseMenu; enableDatabaseSettingsMenuItem: true
                 enableNewPasswordGroupsMenuItem: true
-                enableNewPasswordEntryMenuItem: groupId !== "0"
+                enableNewPasswordEntryMenuItem: groupId !== 0
                 enableSearchMenuItem: !kdbListModel.isEmpty; isTextHideSearch: true }
             PropertyChanges { target: viewPlaceholder; enabled: kdbListModel.isEmpty }
             PropertyChanges { target: searchNoEntriesFoundPlaceholder; enabled: false }
             PropertyChanges { target: busyIndicator; running: false }
             PropertyChanges { target: pageHeader
-                title: groupId === "0" ? qsTr("Password groups") :
+                title: groupId === 0 ? qsTr("Password groups") :
                                        groupsAndEntriesPage.pageTitle }
             PropertyChanges { target: searchField
                 enabled: !kdbListModel.isEmpty }
             PropertyChanges { target: applicationWindow.cover
-                title: groupId === "0" ? qsTr("Password groups") :
+                title: groupId === 0 ? qsTr("Password groups") :
                                        groupsAndEntriesPage.pageTitle
                 state: "GROUPS_VIEW" }
 
@@ -352,16 +352,16 @@ Page {
             name: "SEARCHING"
             PropertyChanges { target: databaseMenu; enableDatabaseSettingsMenuItem: true
                 enableNewPasswordGroupsMenuItem: true
-                enableNewPasswordEntryMenuItem: groupId !== "0"
+                enableNewPasswordEntryMenuItem: groupId !== 0
                 enableSearchMenuItem: true/*searchField.text.length === 0*/; isTextHideSearch: true }
             PropertyChanges { target: viewPlaceholder; enabled: false }
             PropertyChanges { target: searchNoEntriesFoundPlaceholder; enabled: kdbListModel.isEmpty }
             PropertyChanges { target: pageHeader
-                title: groupId === "0" ? qsTr("Search in all groups") :
+                title: groupId === 0 ? qsTr("Search in all groups") :
                                        qsTr("Search in") + " " + groupsAndEntriesPage.pageTitle }
             PropertyChanges { target: searchField; enabled: true }
             PropertyChanges { target: applicationWindow.cover
-                title: groupId === "0" ? qsTr("Search in all groups") :
+                title: groupId === 0 ? qsTr("Search in all groups") :
                                        qsTr("Search in") + " " + groupsAndEntriesPage.pageTitle
                 state: "SEARCH_VIEW" }
 
@@ -387,17 +387,17 @@ Page {
                 // restore group title and state in cover page
                 switch (state) {
                 case "SEARCH_BAR_HIDDEN":
-                    applicationWindow.cover.title = groupId === "0" ? qsTr("Password groups") :
+                    applicationWindow.cover.title = groupId === 0 ? qsTr("Password groups") :
                                                                     groupsAndEntriesPage.pageTitle
                     applicationWindow.cover.state = "GROUPS_VIEW"
                     break
                 case "SEARCH_BAR_SHOWN":
-                    applicationWindow.cover.title = groupId === "0" ? qsTr("Password groups") :
+                    applicationWindow.cover.title = groupId === 0 ? qsTr("Password groups") :
                                                                     groupsAndEntriesPage.pageTitle
                     applicationWindow.cover.state = "GROUPS_VIEW"
                     break
                 case "SEARCHING":
-                    applicationWindow.cover.title = groupId === "0" ? qsTr("Search in all groups") :
+                    applicationWindow.cover.title = groupId === 0 ? qsTr("Search in all groups") :
                                                                     qsTr("Search in") + " " + groupsAndEntriesPage.pageTitle
                     applicationWindow.cover.state = "SEARCH_VIEW"
                     break
@@ -239,7 +239,7 @@ Page {
                     onPasswordClicked: { // returns password
                         // open master groups page and load database in background
                         var masterGroupsPage = pageStack.push(Qt.resolvedUrl("GroupsAndEntriesPage.qml").toString(),
-                                                              { "initOnPageConstruction": false, "groupId": "0" })
+                                                              { "initOnPageConstruction": false, "groupId": 0 })
                         var createNewDatabase =  false
                         internal.openKeepassDatabase(password, createNewDatabase, masterGroupsPage)
                     }
@@ -247,7 +247,7 @@ Page {
                     onPasswordConfirmClicked: { // returns password
                         // open master groups page and load database in background
                         var masterGroupsPage = pageStack.push(Qt.resolvedUrl("GroupsAndEntriesPage.qml").toString(),
-                                                              { "initOnPageConstruction": false, "groupId": "0" })
+                                                              { "initOnPageConstruction": false, "groupId": 0 })
                         var createNewDatabase = true
                         internal.openKeepassDatabase(password, createNewDatabase, masterGroupsPage)
                     }
@@ -632,6 +632,10 @@ Page {
                                           qsTr("Cryptographic algorithms could not be initialized successfully. The database is closed again to prevent any attack. Please try to reopen the app. If the error persists please contact the developer."))
                 masterGroupsPage.closeOnError()
                 break
+            case DatabaseAccessResult.RE_ERR_ITEM_NOT_FOUND:
+                applicationWindow.infoPopup.show(Global.error, qsTr("Internal database error"),
+                                          qsTr("Group or entry \"%1\" does not exist anymore").arg(errorMsg))
+                break
             case DatabaseAccessResult.RE_ERR_QSTRING_TO_INT:
                 applicationWindow.infoPopup.show(Global.error, qsTr("Internal database error"),
                                           qsTr("Conversion of QString \"%1\" to Int failed").arg(errorMsg))
@@ -714,8 +718,8 @@ Page {
           Commonly used for manipulation and creation of entries and groups
           */
         property bool createNewItem: false
-        property string itemId: ""
-        property string parentGroupId: ""
+        property int itemId: 0
+        property int parentGroupId: 0
 
         function saveKdbGroupDetails() {
             // Set group ID and create or save Kdb Group
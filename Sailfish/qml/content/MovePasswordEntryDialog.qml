@@ -31,18 +31,18 @@ Dialog {
     id: movePasswordEntryDialog
 
     // ID of the keepass entry to be moved into another group
-    property string itemId: ""
+    property int itemId: 0
     // ID of group where item is currently placed. This is used to filter out the parent group from the list of groups.
-    property string oldGroupId: ""
+    property int oldGroupId: 0
     // ID of the new parent group of the password item
-    property string newGroupId: ""
+    property int newGroupId: 0
     // Name of password entry to show in dialog cation text
     property string nameOfPasswordEntry: ""
     //
     property KdbEntry kdbEntryToMove
 
     // forbit page navigation if new group is not yet selected
-    canNavigateForward: newGroupId !== ""
+    canNavigateForward: newGroupId !== 0
     allowedOrientations: applicationWindow.orientationSetting
 
     onAccepted: {
@@ -175,7 +175,7 @@ Dialog {
 
                 onClicked: {
                     if(model.id === movePasswordEntryDialog.newGroupId) {
-                        movePasswordEntryDialog.newGroupId = "0";
+                        movePasswordEntryDialog.newGroupId = 0;
                     } else {
                         movePasswordEntryDialog.newGroupId = model.id;
                     }
@@ -47,7 +47,7 @@ Dialog {
     property string password: ""
 
     acceptDestination: Qt.resolvedUrl("GroupsAndEntriesPage.qml").toString()
-    acceptDestinationProperties: { "initOnPageConstruction": false, "groupId": "0" }
+    acceptDestinationProperties: { "initOnPageConstruction": false, "groupId": 0 }
     acceptDestinationAction: PageStackAction.Replace
 
     onDone: {
@@ -30,7 +30,7 @@ Page {
 
     property string pageTitle: ""
     // ID of the keepass entry to be shown
-    property string entryId: ""
+    property int entryId: 0
 
     function setTextFields(keys, values) {
         var maxKeys = keys.length
@@ -21,11 +21,13 @@
 ***************************************************************************/
 
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include "ownKeepassGlobal.h"
 #include "KdbDatabase.h"
 #include "KdbListModel.h"
 #include "private/DatabaseClient.h"
+#include "database/Kdb3Database.h"
 
 using namespace std;
 using namespace kpxPublic;
@@ -38,10 +40,16 @@ KdbDatabase::KdbDatabase(QObject *parent):
     m_keyTransfRounds(50000),
     m_cryptAlgorithm(0),
     m_showUserNamePasswordsInListView(false),
+    m_stageTiming(false),
     m_readOnly(false),
     m_connected(false),
     m_database_type(DatabaseType::DB_TYPE_UNKNOWN)
 {
+    bool ret = connect(&m_calibrationWatcher,
+                       SIGNAL(finished()),
+                       this,
+                       SLOT(slot_keyTransfRoundsCalibrated()));
+    Q_ASSERT(ret);
 }
 
 void KdbDatabase::connectToDatabaseClient()
@@ -87,6 +95,11 @@ void KdbDatabase::connectToDatabaseClient()
                   DatabaseClient::getInstance()->getInterface(),
                   SLOT(slot_setting_sortAlphabeticallyInListView(bool)));
     Q_ASSERT(ret);
+    ret = connect(this,
+                  SIGNAL(setting_stageTiming(bool)),
+                  DatabaseClient::getInstance()->getInterface(),
+                  SLOT(slot_setting_stageTiming(bool)));
+    Q_ASSERT(ret);
     ret = connect(this,
                   SIGNAL(changeDatabasePassword(QString,QString)),
                   DatabaseClient::getInstance()->getInterface(),
@@ -117,6 +130,21 @@ void KdbDatabase::connectToDatabaseClient()
                   this,
                   SLOT(slot_databaseCryptAlgorithmChanged(int)));
     Q_ASSERT(ret);
+    ret = connect(this,
+                  SIGNAL(calibrateDatabaseKeyTransfRounds(int)),
+                  DatabaseClient::getInstance()->getInterface(),
+                  SLOT(slot_calibrateKeyTransfRounds(int)));
+    Q_ASSERT(ret);
+    ret = connect(DatabaseClient::getInstance()->getInterface(),
+                  SIGNAL(keyTransfRoundsCalibrated(int,int)),
+                  this,
+                  SIGNAL(keyTransfRoundsCalibrated(int,int)));
+    Q_ASSERT(ret);
+    ret = connect(DatabaseClient::getInstance()->getInterface(),
+                  SIGNAL(stagesTimed(QString,QVariantList)),
+                  this,
+                  SIGNAL(stagesTimed(QString,QVariantList)));
+    Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
                   SIGNAL(errorOccured(int,QString)),
                   this,
@@ -157,6 +185,7 @@ void KdbDatabase::open(const int databaseType, const QString& dbFilePath, const
     // send settings to new created database client interface
     emit setting_showUserNamePasswordsInListView(m_showUserNamePasswordsInListView);
     emit setting_sortAlphabeticallyInListView(m_sortAlphabeticallyInListView);
+    emit setting_stageTiming(m_stageTiming);
 
     // send signal to the global Keepass database interface component
     emit openDatabase(dbFilePath, password, keyFilePath, readonly);
@@ -202,6 +231,7 @@ void KdbDatabase::create(const int databaseType, const QString& dbFilePath, cons
     // send settings to new created database client interface
     emit setting_showUserNamePasswordsInListView(m_showUserNamePasswordsInListView);
     emit setting_sortAlphabeticallyInListView(m_sortAlphabeticallyInListView);
+    emit setting_stageTiming(m_stageTiming);
 
     // send signal to database client interface
     emit createNewDatabase(dbFilePath, password, keyFilePath, m_cryptAlgorithm, m_keyTransfRounds);
@@ -234,3 +264,19 @@ void KdbDatabase::changePassword(const QString &password, const QString &keyFile
         emit changeDatabasePassword(password, keyFile);
     }
 }
+
+void KdbDatabase::calibrateKeyTransfRounds(const int targetTime)
+{
+    if (m_connected) {
+        emit calibrateDatabaseKeyTransfRounds(targetTime);
+    } else if (!m_calibrationWatcher.isRunning()) {
+        // without database interface the measurement is done in a worker thread to not block the UI
+        m_calibrationWatcher.setFuture(QtConcurrent::run(KeyTransformBenchmark::benchmark, targetTime));
+    }
+}
+
+void KdbDatabase::slot_keyTransfRoundsCalibrated()
+{
+    // there is no database, so no open time to compare with
+    emit keyTransfRoundsCalibrated(m_calibrationWatcher.result(), -1);
+}
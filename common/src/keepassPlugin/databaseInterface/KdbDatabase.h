@@ -25,6 +25,8 @@
 
 #include <QObject>
 #include <QFile>
+#include <QFutureWatcher>
+#include <QVariantList>
 #include "private/AbstractDatabaseFactory.h"
 
 namespace kpxPublic {
@@ -38,6 +40,8 @@ public:
     Q_PROPERTY(int cryptAlgorithm READ cryptAlgorithm WRITE setCryptAlgorithm NOTIFY cryptAlgorithmChanged)
     Q_PROPERTY(bool showUserNamePasswordsInListView READ showUserNamePasswordsInListView WRITE setShowUserNamePasswordsInListView STORED true SCRIPTABLE true)
     Q_PROPERTY(bool sortAlphabeticallyInListView READ sortAlphabeticallyInListView WRITE setSortAlphabeticallyInListView STORED true SCRIPTABLE true)
+    // If enabled the duration of each stage of opening, saving and searching the database is measured and signalled with stagesTimed()
+    Q_PROPERTY(bool stageTiming READ stageTiming WRITE setStageTiming STORED true SCRIPTABLE true)
     Q_PROPERTY(bool readOnly READ readOnly NOTIFY readOnlyChanged)
     Q_PROPERTY(int type READ type NOTIFY typeChanged)
 
@@ -46,19 +50,32 @@ public: // QtQuick 1.1 needs here a public keyword otherwise if does not find th
     Q_INVOKABLE void create(const int databaseType, const QString& dbFilePath, const QString &keyFilePath, const QString& password);
     Q_INVOKABLE void close();
     Q_INVOKABLE void changePassword(const QString& password, const QString &keyFile);
+    // Measures the key transformation speed of this device, result is signalled with keyTransfRoundsCalibrated()
+    Q_INVOKABLE void calibrateKeyTransfRounds(const int targetTime);
 
 public:
     KdbDatabase(QObject* parent=0);
     virtual ~KdbDatabase() {}
 
     int keyTransfRounds() const { return m_keyTransfRounds; }
-    void setKeyTransfRounds(const int value) { emit changeDatabaseKeyTransfRounds(value); }
+    // A negative value calibrates the rounds on this device to take -value milliseconds for opening the database
+    // If no database is open the value is used for the next database which is created
+    void setKeyTransfRounds(const int value) {
+        if (m_connected) {
+            emit changeDatabaseKeyTransfRounds(value);
+        } else if (value != m_keyTransfRounds) {
+            m_keyTransfRounds = value;
+            emit keyTransfRoundsChanged();
+        }
+    }
     int cryptAlgorithm() const { return m_cryptAlgorithm; }
     void setCryptAlgorithm(const int value) { emit changeDatabaseCryptAlgorithm(value); }
     bool showUserNamePasswordsInListView() const { return m_showUserNamePasswordsInListView; }
     void setShowUserNamePasswordsInListView(bool value) { m_showUserNamePasswordsInListView = value; emit setting_showUserNamePasswordsInListView(value); }
     bool sortAlphabeticallyInListView() const { return m_sortAlphabeticallyInListView; }
     void setSortAlphabeticallyInListView(const bool value) { m_sortAlphabeticallyInListView = value; emit setting_sortAlphabeticallyInListView(value); }
+    bool stageTiming() const { return m_stageTiming; }
+    void setStageTiming(const bool value) { m_stageTiming = value; emit setting_stageTiming(value); }
     bool readOnly() const { return m_readOnly; }
     int type() const { return m_database_type; }
 
@@ -70,8 +87,10 @@ signals:
     void changeDatabasePassword(QString password, QString keyFile);
     void changeDatabaseKeyTransfRounds(int value);
     void changeDatabaseCryptAlgorithm(int value);
+    void calibrateDatabaseKeyTransfRounds(int targetTime);
     void setting_showUserNamePasswordsInListView(bool value);
     void setting_sortAlphabeticallyInListView(bool value);
+    void setting_stageTiming(bool value);
 
     // signals to QML
     void databaseOpened(int result, QString errorMsg);
@@ -80,6 +99,9 @@ signals:
     void databasePasswordChanged();
     void keyTransfRoundsChanged();
     void cryptAlgorithmChanged();
+    void keyTransfRoundsCalibrated(int rounds, int openTime);
+    // operation is "open", "save" or "search", each stage is a map with "name", "nsecs" and "bytes"
+    void stagesTimed(QString operation, QVariantList stages);
     void errorOccured(int result, QString errorMsg);
     void readOnlyChanged();
     void typeChanged();
@@ -100,6 +122,7 @@ private slots:
     }
     void slot_databaseClosed();
     void slot_databaseOpened(int result, QString errorMsg);
+    void slot_keyTransfRoundsCalibrated();
 
 private:
     void connectToDatabaseClient();
@@ -112,11 +135,14 @@ private:
     // Settings are simply passed over to the backend thread
     bool m_showUserNamePasswordsInListView;
     bool m_sortAlphabeticallyInListView;
+    bool m_stageTiming;
 
     bool m_readOnly;
 
     bool m_connected;
     int m_database_type;
+    // measures the key transformation speed if no database is open
+    QFutureWatcher<int> m_calibrationWatcher;
     Q_DISABLE_COPY(KdbDatabase)
 };
 
@@ -31,7 +31,7 @@ using namespace ownKeepassPublic;
 
 KdbEntry::KdbEntry(QObject *parent)
     : QObject(parent),
-      m_entryId(""),
+      m_entryId(0),
       m_connected(false),
       m_new_entry_triggered(false)
 {}
@@ -44,54 +44,54 @@ bool KdbEntry::connectToDatabaseClient()
     }
     // if OK then connect signals to backend
     bool ret = connect(this,
-                       SIGNAL(loadEntryFromKdbDatabase(QString)),
+                       SIGNAL(loadEntryFromKdbDatabase(quint32)),
                        DatabaseClient::getInstance()->getInterface(),
-                       SLOT(slot_loadEntry(QString)));
+                       SLOT(slot_loadEntry(quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(entryLoaded(int,QString,QList<QString>,QList<QString>)),
+                  SIGNAL(entryLoaded(int,quint32,QList<QString>,QList<QString>)),
                   this,
-                  SLOT(slot_entryDataLoaded(int,QString,QList<QString>,QList<QString>)));
+                  SLOT(slot_entryDataLoaded(int,quint32,QList<QString>,QList<QString>)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(saveEntryToKdbDatabase(QString,QString,QString,QString,QString,QString)),
+                  SIGNAL(saveEntryToKdbDatabase(quint32,QString,QString,QString,QString,QString)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_saveEntry(QString,QString,QString,QString,QString,QString)));
+                  SLOT(slot_saveEntry(quint32,QString,QString,QString,QString,QString)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(entrySaved(int,QString)),
+                  SIGNAL(entrySaved(int,quint32)),
                   this,
-                  SLOT(slot_entryDataSaved(int,QString)));
+                  SLOT(slot_entryDataSaved(int,quint32)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(createNewEntryInKdbDatabase(QString,QString,QString,QString,QString,QString)),
+                  SIGNAL(createNewEntryInKdbDatabase(QString,QString,QString,QString,QString,quint32)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_createNewEntry(QString,QString,QString,QString,QString,QString)));
+                  SLOT(slot_createNewEntry(QString,QString,QString,QString,QString,quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(newEntryCreated(int, QString)),
+                  SIGNAL(newEntryCreated(int, quint32)),
                   this,
-                  SLOT(slot_newEntryCreated(int, QString)));
+                  SLOT(slot_newEntryCreated(int, quint32)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(deleteEntryFromKdbDatabase(QString)),
+                  SIGNAL(deleteEntryFromKdbDatabase(quint32)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_deleteEntry(QString)));
+                  SLOT(slot_deleteEntry(quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(entryDeleted(int,QString)),
+                  SIGNAL(entryDeleted(int,quint32)),
                   this,
-                  SLOT(slot_entryDeleted(int,QString)));
+                  SLOT(slot_entryDeleted(int,quint32)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(moveEntryInKdbDatabase(QString,QString)),
+                  SIGNAL(moveEntryInKdbDatabase(quint32,quint32)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_moveEntry(QString,QString)));
+                  SLOT(slot_moveEntry(quint32,quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(entryMoved(int,QString)),
+                  SIGNAL(entryMoved(int,quint32)),
                   this,
-                  SLOT(slot_entryMoved(int,QString)));
+                  SLOT(slot_entryMoved(int,quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
                   SIGNAL(disconnectAllClients()),
@@ -114,7 +114,7 @@ void KdbEntry::disconnectFromDatabaseClient()
 //    Q_ASSERT(ret);
 
     m_connected = false;
-    m_entryId = "";
+    m_entryId = 0;
     m_new_entry_triggered = false;
 }
 
@@ -125,7 +125,7 @@ KdbEntry::~KdbEntry()
 
 void KdbEntry::loadEntryData()
 {
-    Q_ASSERT(m_entryId != "");
+    Q_ASSERT(m_entryId != 0);
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         QList<QString> emptyList;
@@ -142,7 +142,7 @@ void KdbEntry::saveEntryData(QString title,
                              QString password,
                              QString comment)
 {
-    Q_ASSERT(m_entryId != "");
+    Q_ASSERT(m_entryId != 0);
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit entryDataSaved(DatabaseAccessResult::RE_DB_NOT_OPENED);
@@ -157,9 +157,8 @@ void KdbEntry::createNewEntry(QString title,
                               QString username,
                               QString password,
                               QString comment,
-                              QString parentgroupId)
+                              quint32 parentgroupId)
 {
-    Q_ASSERT(parentgroupId != "");
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit newEntryCreated(DatabaseAccessResult::RE_DB_NOT_OPENED, 0);
@@ -172,7 +171,7 @@ void KdbEntry::createNewEntry(QString title,
 
 void KdbEntry::deleteEntry()
 {
-    Q_ASSERT(m_entryId != "");
+    Q_ASSERT(m_entryId != 0);
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit entryDeleted(DatabaseAccessResult::RE_DB_NOT_OPENED);
@@ -182,10 +181,9 @@ void KdbEntry::deleteEntry()
     }
 }
 
-void KdbEntry::moveEntry(QString newGroupId)
+void KdbEntry::moveEntry(quint32 newGroupId)
 {
-    Q_ASSERT(m_entryId != "");
-    Q_ASSERT(newGroupId != "");
+    Q_ASSERT(m_entryId != 0);
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit entryMoved(DatabaseAccessResult::RE_DB_NOT_OPENED);
@@ -196,25 +194,25 @@ void KdbEntry::moveEntry(QString newGroupId)
 }
 
 void KdbEntry::slot_entryDataLoaded(int result,
-                                    QString entryId,
+                                    quint32 entryId,
                                     QList<QString> keys,
                                     QList<QString> values)
 {
     // forward signal to QML only if the signal is for us
-    if (entryId.compare(m_entryId) == 0) {
+    if (entryId == m_entryId) {
         emit entryDataLoaded(result, keys, values);
     }
 }
 
-void KdbEntry::slot_entryDataSaved(int result, QString entryId)
+void KdbEntry::slot_entryDataSaved(int result, quint32 entryId)
 {
     // forward signal to QML only if the signal is for us
-    if (entryId.compare(m_entryId) == 0) {
+    if (entryId == m_entryId) {
         emit entryDataSaved(result);
     }
 }
 
-void KdbEntry::slot_newEntryCreated(int result, QString entryId)
+void KdbEntry::slot_newEntryCreated(int result, quint32 entryId)
 {
     if (m_new_entry_triggered) {
         if (result == DatabaseAccessResult::RE_OK) {
@@ -226,19 +224,19 @@ void KdbEntry::slot_newEntryCreated(int result, QString entryId)
     }
 }
 
-void KdbEntry::slot_entryDeleted(int result, QString entryId)
+void KdbEntry::slot_entryDeleted(int result, quint32 entryId)
 {
     // forward signal to QML only if the signal is for us
-    if (entryId.compare(m_entryId) == 0) {
+    if (entryId == m_entryId) {
         emit entryDeleted(result);
-        m_entryId = "";
+        m_entryId = 0;
     }
 }
 
-void KdbEntry::slot_entryMoved(int result, QString entryId)
+void KdbEntry::slot_entryMoved(int result, quint32 entryId)
 {
     // forward signal to QML only if the signal is for us
-    if (entryId.compare(m_entryId) == 0) {
+    if (entryId == m_entryId) {
         emit entryMoved(result);
     }
 }
@@ -33,7 +33,7 @@ class KdbEntry : public QObject
     Q_OBJECT
 
 public:
-    Q_PROPERTY(QString entryId READ getEntryId WRITE setEntryId STORED true SCRIPTABLE true)
+    Q_PROPERTY(quint32 entryId READ getEntryId WRITE setEntryId STORED true SCRIPTABLE true)
 
 public:
     Q_INVOKABLE void loadEntryData();
@@ -47,9 +47,9 @@ public:
                                     QString username,
                                     QString password,
                                     QString comment,
-                                    QString parentgroupId);
+                                    quint32 parentgroupId);
     Q_INVOKABLE void deleteEntry();
-    Q_INVOKABLE void moveEntry(QString newGroupId);
+    Q_INVOKABLE void moveEntry(quint32 newGroupId);
 
 signals:
     // signals to QML
@@ -57,13 +57,13 @@ signals:
                          QList<QString> keys,
                          QList<QString> values);
     void entryDataSaved(int result);
-    void newEntryCreated(int result, QString newEntryId);
+    void newEntryCreated(int result, quint32 newEntryId);
     void entryDeleted(int result);
     void entryMoved(int result);
 
     // signals to interface of database client
-    void loadEntryFromKdbDatabase(QString entryId);
-    void saveEntryToKdbDatabase(QString entryId,
+    void loadEntryFromKdbDatabase(quint32 entryId);
+    void saveEntryToKdbDatabase(quint32 entryId,
                                 QString title,
                                 QString url,
                                 QString username,
@@ -74,35 +74,35 @@ signals:
                                      QString username,
                                      QString password,
                                      QString comment,
-                                     QString parentgroupId);
-    void deleteEntryFromKdbDatabase(QString entryId);
-    void moveEntryInKdbDatabase(QString entryId, QString newGroupId);
+                                     quint32 parentgroupId);
+    void deleteEntryFromKdbDatabase(quint32 entryId);
+    void moveEntryInKdbDatabase(quint32 entryId, quint32 newGroupId);
 
 public slots:
     // signals from interface of database client
     void slot_entryDataLoaded(int result,
-                              QString entryId,
+                              quint32 entryId,
                               QList<QString> keys,
                               QList<QString> values);
-    void slot_entryDataSaved(int result, QString entryId);
-    void slot_entryDeleted(int result, QString entryId);
-    void slot_entryMoved(int result, QString entryId);
-    void slot_newEntryCreated(int result, QString entryId);
+    void slot_entryDataSaved(int result, quint32 entryId);
+    void slot_entryDeleted(int result, quint32 entryId);
+    void slot_entryMoved(int result, quint32 entryId);
+    void slot_newEntryCreated(int result, quint32 entryId);
     void slot_disconnectFromDatabaseClient();
 
 public:
     KdbEntry(QObject *parent = 0);
     virtual ~KdbEntry();
 
-    QString getEntryId() const { return m_entryId; }
-    void setEntryId(const QString value) { m_entryId = value; }
+    quint32 getEntryId() const { return m_entryId; }
+    void setEntryId(const quint32 value) { m_entryId = value; }
 
 private:
     bool connectToDatabaseClient();
     void disconnectFromDatabaseClient();
 
 private:
-    QString m_entryId;
+    quint32 m_entryId;
     bool m_connected;
     bool m_new_entry_triggered;
 };
@@ -31,7 +31,7 @@ using namespace ownKeepassPublic;
 
 KdbGroup::KdbGroup(QObject *parent)
     : QObject(parent),
-      m_groupId(""),
+      m_groupId(0),
       m_connected(false),
       m_new_group_triggered(false)
 {}
@@ -44,44 +44,44 @@ bool KdbGroup::connectToDatabaseClient()
     }
     // if OK then connect signals to backend
     bool ret = connect(this,
-                       SIGNAL(loadGroupFromKdbDatabase(QString)),
+                       SIGNAL(loadGroupFromKdbDatabase(quint32)),
                        DatabaseClient::getInstance()->getInterface(),
-                       SLOT(slot_loadGroup(QString)));
+                       SLOT(slot_loadGroup(quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(groupLoaded(int, QString, QString)),
+                  SIGNAL(groupLoaded(int, quint32, QString)),
                   this,
-                  SLOT(slot_groupDataLoaded(int,QString,QString)));
+                  SLOT(slot_groupDataLoaded(int,quint32,QString)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(saveGroupToKdbDatabase(QString, QString)),
+                  SIGNAL(saveGroupToKdbDatabase(quint32, QString)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_saveGroup(QString, QString)));
+                  SLOT(slot_saveGroup(quint32, QString)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(groupSaved(int,QString)),
+                  SIGNAL(groupSaved(int,quint32)),
                   this,
-                  SLOT(slot_groupDataSaved(int,QString)));
+                  SLOT(slot_groupDataSaved(int,quint32)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(createNewGroupInKdbDatabase(QString,quint32,QString)),
+                  SIGNAL(createNewGroupInKdbDatabase(QString,quint32,quint32)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_createNewGroup(QString,quint32,QString)));
+                  SLOT(slot_createNewGroup(QString,quint32,quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(newGroupCreated(int, QString)),
+                  SIGNAL(newGroupCreated(int, quint32)),
                   this,
-                  SLOT(slot_newGroupCreated(int, QString)));
+                  SLOT(slot_newGroupCreated(int, quint32)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(deleteGroupFromKdbDatabase(QString)),
+                  SIGNAL(deleteGroupFromKdbDatabase(quint32)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_deleteGroup(QString)));
+                  SLOT(slot_deleteGroup(quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(groupDeleted(int,QString)),
+                  SIGNAL(groupDeleted(int,quint32)),
                   this,
-                  SLOT(slot_groupDeleted(int,QString)));
+                  SLOT(slot_groupDeleted(int,quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
                   SIGNAL(disconnectAllClients()),
@@ -103,13 +103,13 @@ void KdbGroup::disconnectFromDatabaseClient()
 //    Q_ASSERT(ret);
 
     m_connected = false;
-    m_groupId = "";
+    m_groupId = 0;
     m_new_group_triggered = false;
 }
 
 void KdbGroup::loadGroupData()
 {
-    Q_ASSERT(m_groupId != "");
+    Q_ASSERT(m_groupId != 0);
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit groupDataLoaded(DatabaseAccessResult::RE_DB_NOT_OPENED, "");
@@ -121,7 +121,7 @@ void KdbGroup::loadGroupData()
 
 void KdbGroup::saveGroupData(QString title)
 {
-    Q_ASSERT(m_groupId != "");
+    Q_ASSERT(m_groupId != 0);
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit groupDataSaved(DatabaseAccessResult::RE_DB_NOT_OPENED);
@@ -131,9 +131,8 @@ void KdbGroup::saveGroupData(QString title)
     }
 }
 
-void KdbGroup::createNewGroup(QString title, QString parentGroupId)
+void KdbGroup::createNewGroup(QString title, quint32 parentGroupId)
 {
-    Q_ASSERT(parentGroupId != "");
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit newGroupCreated(DatabaseAccessResult::RE_DB_NOT_OPENED);
@@ -148,7 +147,7 @@ void KdbGroup::createNewGroup(QString title, QString parentGroupId)
 
 void KdbGroup::deleteGroup()
 {
-    Q_ASSERT(m_groupId != "");
+    Q_ASSERT(m_groupId != 0);
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit groupDeleted(DatabaseAccessResult::RE_DB_NOT_OPENED);
@@ -158,10 +157,9 @@ void KdbGroup::deleteGroup()
     }
 }
 
-void KdbGroup::moveGroup(QString newParentGroupId)
+void KdbGroup::moveGroup(quint32 newParentGroupId)
 {
-    Q_ASSERT(m_groupId != "");
-    Q_ASSERT(newParentGroupId != "");
+    Q_ASSERT(m_groupId != 0);
     if (!m_connected && !connectToDatabaseClient()) {
         // if not successfully connected just return an error
         emit groupMoved(DatabaseAccessResult::RE_DB_NOT_OPENED);
@@ -171,23 +169,23 @@ void KdbGroup::moveGroup(QString newParentGroupId)
     }
 }
 
-void KdbGroup::slot_groupDataLoaded(int result, QString groupId, QString title)
+void KdbGroup::slot_groupDataLoaded(int result, quint32 groupId, QString title)
 {
     // forward signal to QML only if the signal is for us
-    if (groupId.compare(m_groupId) == 0) {
+    if (groupId == m_groupId) {
         emit groupDataLoaded(result, title);
     }
 }
 
-void KdbGroup::slot_groupDataSaved(int result, QString groupId)
+void KdbGroup::slot_groupDataSaved(int result, quint32 groupId)
 {
     // forward signal to QML only if the signal is for us
-    if (groupId.compare(m_groupId) == 0) {
+    if (groupId == m_groupId) {
         emit groupDataSaved(result);
     }
 }
 
-void KdbGroup::slot_newGroupCreated(int result, QString groupId)
+void KdbGroup::slot_newGroupCreated(int result, quint32 groupId)
 {
     if (m_new_group_triggered) {
         if (result == DatabaseAccessResult::RE_OK) {
@@ -199,19 +197,19 @@ void KdbGroup::slot_newGroupCreated(int result, QString groupId)
     }
 }
 
-void KdbGroup::slot_groupDeleted(int result, QString groupId)
+void KdbGroup::slot_groupDeleted(int result, quint32 groupId)
 {
     // forward signal to QML only if the signal is for us
-    if (groupId.compare(m_groupId) == 0) {
+    if (groupId == m_groupId) {
         emit groupDeleted(result);
-        m_groupId = "";
+        m_groupId = 0;
     }
 }
 
-void KdbGroup::slot_groupMoved(int result, QString groupId)
+void KdbGroup::slot_groupMoved(int result, quint32 groupId)
 {
     // forward signal to QML only if the signal is for us
-    if (groupId.compare(m_groupId) == 0) {
+    if (groupId == m_groupId) {
         emit groupMoved(result);
     }
 }
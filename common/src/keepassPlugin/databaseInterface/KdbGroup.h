@@ -33,14 +33,14 @@ class KdbGroup : public QObject
     Q_OBJECT
 
 public:
-    Q_PROPERTY(QString groupId READ getGroupId WRITE setGroupId STORED true SCRIPTABLE true)
+    Q_PROPERTY(quint32 groupId READ getGroupId WRITE setGroupId STORED true SCRIPTABLE true)
 
 public:
     Q_INVOKABLE void loadGroupData();
-    Q_INVOKABLE void createNewGroup(QString title, QString parentGroupId);
+    Q_INVOKABLE void createNewGroup(QString title, quint32 parentGroupId);
     Q_INVOKABLE void saveGroupData(QString title);
     Q_INVOKABLE void deleteGroup();
-    Q_INVOKABLE void moveGroup(QString newParentGroupId);
+    Q_INVOKABLE void moveGroup(quint32 newParentGroupId);
 
 signals:
     // signals to QML
@@ -51,34 +51,34 @@ signals:
     void groupMoved(int result);
 
     // signals to database client
-    void loadGroupFromKdbDatabase(QString groupId);
-    void saveGroupToKdbDatabase(QString groupId, QString title);
-    void createNewGroupInKdbDatabase(QString title, quint32 iconId, QString parentGroupId);
-    void deleteGroupFromKdbDatabase(QString groupId);
-    void moveGroupInKdbDatabase(QString groupId, QString newGroupId);
+    void loadGroupFromKdbDatabase(quint32 groupId);
+    void saveGroupToKdbDatabase(quint32 groupId, QString title);
+    void createNewGroupInKdbDatabase(QString title, quint32 iconId, quint32 parentGroupId);
+    void deleteGroupFromKdbDatabase(quint32 groupId);
+    void moveGroupInKdbDatabase(quint32 groupId, quint32 newGroupId);
 
 public slots:
     // signals from database client
-    void slot_groupDataLoaded(int result, QString groupId, QString title);
-    void slot_groupDataSaved(int result, QString groupId);
-    void slot_newGroupCreated(int result, QString groupId);
-    void slot_groupDeleted(int result, QString groupId);
-    void slot_groupMoved(int result, QString groupId);
+    void slot_groupDataLoaded(int result, quint32 groupId, QString title);
+    void slot_groupDataSaved(int result, quint32 groupId);
+    void slot_newGroupCreated(int result, quint32 groupId);
+    void slot_groupDeleted(int result, quint32 groupId);
+    void slot_groupMoved(int result, quint32 groupId);
     void slot_disconnectFromDatabaseClient();
 
 public:
     KdbGroup(QObject *parent = 0);
     virtual ~KdbGroup() {}
 
-    QString getGroupId() const { return m_groupId; }
-    void setGroupId(const QString value) { m_groupId = value; }
+    quint32 getGroupId() const { return m_groupId; }
+    void setGroupId(const quint32 value) { m_groupId = value; }
 
 private:
     bool connectToDatabaseClient();
     void disconnectFromDatabaseClient();
 
 private:
-    QString m_groupId;
+    quint32 m_groupId;
     bool m_connected;
     bool m_new_group_triggered;
 };
@@ -21,6 +21,7 @@
 ***************************************************************************/
 
 #include <QDebug>
+#include <QtAlgorithms>
 #include "ownKeepassGlobal.h"
 #include "KdbListModel.h"
 #include "private/DatabaseClient.h"
@@ -29,14 +30,26 @@ using namespace kpxPublic;
 using namespace kpxPrivate;
 using namespace ownKeepassPublic;
 
+// maximum number of pages which are cached in windowed mode
+static const int MAX_CACHED_PAGES = 8;
+
+static bool kdbItemLessThan(const KdbItem& a, const KdbItem& b)
+{
+    return a.m_sortKey < b.m_sortKey;
+}
+
 KdbListModel::KdbListModel(QObject *parent)
     : QAbstractListModel(parent),
-      m_modelId(""),
+      m_modelId(0),
       m_numGroups(0),
       m_numEntries(0),
+      m_hasItemLevels(false),
       m_registered(false),
-      m_searchRootGroupId(""),
-      m_connected(false)
+      m_searchRootGroupId(0),
+      m_connected(false),
+      m_windowed(false),
+      m_numItems(0),
+      m_numFetched(0)
 {}
 
 bool KdbListModel::connectToDatabaseClient()
@@ -57,9 +70,9 @@ bool KdbListModel::connectToDatabaseClient()
                   SIGNAL(masterGroupsLoaded(int)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(loadGroupsAndEntries(QString)),
+                  SIGNAL(loadGroupsAndEntries(quint32)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_loadGroupsAndEntries(QString)));
+                  SLOT(slot_loadGroupsAndEntries(quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
                   SIGNAL(groupsAndEntriesLoaded(int)),
@@ -67,44 +80,24 @@ bool KdbListModel::connectToDatabaseClient()
                   SIGNAL(groupsAndEntriesLoaded(int)));
     Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(searchEntries(QString,QString)),
+                  SIGNAL(searchEntries(QString,quint32)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_searchEntries(QString,QString)));
+                  SLOT(slot_searchEntries(QString,quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
                   SIGNAL(searchEntriesCompleted(int)),
                   this,
                   SIGNAL(searchEntriesCompleted(int)));
     Q_ASSERT(ret);
-    ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(appendItemToListModel(QString, QString, QString, int, int, QString)),
-                  this,
-                  SLOT(slot_appendItemToListModel(QString, QString, QString, int, int, QString)));
-    Q_ASSERT(ret);
-    ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(addItemToListModelSorted(QString, QString, QString, int, int, QString)),
-                  this,
-                  SLOT(slot_addItemToListModelSorted(QString, QString, QString, int, int, QString)));
-    Q_ASSERT(ret);
-    ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(updateItemInListModel(QString, QString, QString, QString)),
-                  this,
-                  SLOT(slot_updateItemInListModel(QString, QString, QString, QString)));
-    Q_ASSERT(ret);
-    ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(updateItemInListModelSorted(QString, QString, QString, QString)),
-                  this,
-                  SLOT(slot_updateItemInListModelSorted(QString, QString, QString, QString)));
-    Q_ASSERT(ret);
     ret = connect(this,
-                  SIGNAL(unregisterFromDatabaseClient(QString)),
+                  SIGNAL(loadListModelPage(quint32, int, int)),
                   DatabaseClient::getInstance()->getInterface(),
-                  SLOT(slot_unregisterListModel(QString)));
+                  SLOT(slot_loadListModelPage(quint32, int, int)));
     Q_ASSERT(ret);
-    ret = connect(DatabaseClient::getInstance()->getInterface(),
-                  SIGNAL(deleteItemInListModel(QString)),
-                  this,
-                  SLOT(slot_deleteItem(QString)));
+    ret = connect(this,
+                  SIGNAL(unregisterFromDatabaseClient(quint32)),
+                  DatabaseClient::getInstance()->getInterface(),
+                  SLOT(slot_unregisterListModel(quint32)));
     Q_ASSERT(ret);
     ret = connect(DatabaseClient::getInstance()->getInterface(),
                   SIGNAL(disconnectAllClients()),
@@ -112,6 +105,7 @@ bool KdbListModel::connectToDatabaseClient()
                   SLOT(slot_disconnectFromDatabaseClient()));
     Q_ASSERT(ret);
 
+    // items for this list model are passed on by the database client, see subscribeListModel()
     qDebug() << "KdbListModel connected";
 
     m_connected = true;
@@ -127,9 +121,10 @@ void KdbListModel::disconnectFromDatabaseClient()
 //    bool ret = disconnect(this, 0, 0, 0);
 //    Q_ASSERT(ret);
 
+    DatabaseClient::getInstance()->unsubscribeListModel(this);
     m_connected = false;
     m_registered = false;
-    m_modelId = "";
+    m_modelId = 0;
 }
 
 KdbListModel::~KdbListModel()
@@ -137,6 +132,7 @@ KdbListModel::~KdbListModel()
     if (m_registered) {
         emit unregisterFromDatabaseClient(m_modelId);
     }
+    DatabaseClient::getInstance()->unsubscribeListModel(this);
     qDebug() << "KdbListModel destroyed";
 }
 
@@ -154,6 +150,10 @@ void KdbListModel::loadMasterGroupsFromDatabase()
             emit unregisterFromDatabaseClient(m_modelId);
             m_registered = false;
         }
+        // list model of master groups has always modelId 0
+        m_registered = true;
+        m_modelId = 0;
+        DatabaseClient::getInstance()->subscribeListModel(m_modelId, this);
         // send signal to global interface of keepass database to get master groups
         emit loadMasterGroups(true);
     }
@@ -176,13 +176,14 @@ void KdbListModel::loadGroupListFromDatabase()
         // this list model is only used in a dialog and is thrown away afterwards, so it does not need to be registered
         // i.e. changes on the database which are normally reflecte to list models are not needed here
         m_registered = true;
-        m_modelId = "ffffffff";
+        m_modelId = 0xffffffff;
+        DatabaseClient::getInstance()->subscribeListModel(m_modelId, this);
         // send signal to global interface of keepass database to get master groups
         emit loadMasterGroups(false);
     }
 }
 
-void KdbListModel::loadGroupsAndEntriesFromDatabase(QString groupId)
+void KdbListModel::loadGroupsAndEntriesFromDatabase(quint32 groupId)
 {
     // make list view empty and unregister if necessary
     if (!isEmpty()) {
@@ -196,6 +197,10 @@ void KdbListModel::loadGroupsAndEntriesFromDatabase(QString groupId)
             emit unregisterFromDatabaseClient(m_modelId);
             m_registered = false;
         }
+        // list model gets groupId as its unique ID
+        m_registered = true;
+        m_modelId = groupId;
+        DatabaseClient::getInstance()->subscribeListModel(m_modelId, this);
         // send signal to global interface of keepass database to get entries and subgroups
         emit loadGroupsAndEntries(groupId);
     }
@@ -203,6 +208,12 @@ void KdbListModel::loadGroupsAndEntriesFromDatabase(QString groupId)
 
 void KdbListModel::searchEntriesInKdbDatabase(QString searchString)
 {
+    if (m_connected && m_registered && m_modelId == 0xfffffffe) {
+        // list model shows already a search result, the database interface either removes the entries
+        // which do not match the new search string anymore or clears the list model and sends a new result
+        emit searchEntries(searchString, m_searchRootGroupId);
+        return;
+    }
     // make list view empty and unregister if necessary
     if (!isEmpty()) {
         clear();
@@ -216,8 +227,9 @@ void KdbListModel::searchEntriesInKdbDatabase(QString searchString)
             m_registered = false;
         }
         // list model for searching is 0xfffffffe per default, so set it here already
-        m_modelId = "fffffffe";
+        m_modelId = 0xfffffffe;
         m_registered = true;
+        DatabaseClient::getInstance()->subscribeListModel(m_modelId, this);
 
         // send signal to backend to start search in database
         emit searchEntries(searchString, m_searchRootGroupId);
@@ -227,29 +239,100 @@ void KdbListModel::searchEntriesInKdbDatabase(QString searchString)
 int KdbListModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent);
+    if (m_windowed) {
+        return m_numFetched;
+    }
     return m_items.count();
 }
 
 bool KdbListModel::isEmpty()
 {
+    if (m_windowed) {
+        return m_numItems == 0;
+    }
     return m_items.isEmpty();
 }
 
 QVariant KdbListModel::data(const QModelIndex &index, int role) const
 {
+    if (m_windowed) {
+        if (index.row() < 0 || index.row() >= m_numFetched)
+            return QVariant();
+
+        int page = index.row() / LIST_MODEL_PAGE_SIZE;
+        QHash<int, QList<KdbItem> >::const_iterator it = m_pages.constFind(page);
+        if (it == m_pages.constEnd()) {
+            // page was dropped from the cache, show an empty item until it is loaded again
+            requestPage(page);
+            return KdbItem().get(role);
+        }
+        // mark page as most recently used
+        if (m_pageLru.first() != page) {
+            m_pageLru.removeOne(page);
+            m_pageLru.prepend(page);
+        }
+        int i = index.row() - page * LIST_MODEL_PAGE_SIZE;
+        if (i >= it.value().count())
+            return KdbItem().get(role);
+        return it.value()[i].get(role);
+    }
+
     if (index.row() < 0 || index.row() >= m_items.count())
         return QVariant();
 
     return m_items[index.row()].get(role);
 }
 
+bool KdbListModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return false;
+    return m_windowed && m_numFetched < m_numItems;
+}
+
+void KdbListModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) return;
+    // the page with the next row to show might be only partly shown, so get it completely
+    int page = m_numFetched / LIST_MODEL_PAGE_SIZE;
+    m_pages.remove(page);
+    m_pageLru.removeOne(page);
+    requestPage(page);
+}
+
+void KdbListModel::requestPage(int page) const
+{
+    if (m_requestedPages.contains(page)) return;
+    m_requestedPages.insert(page);
+    emit loadListModelPage(m_modelId, page * LIST_MODEL_PAGE_SIZE, LIST_MODEL_PAGE_SIZE);
+}
+
+void KdbListModel::invalidatePagesFrom(int row)
+{
+    // items behind row have moved, so drop all pages from the one containing row
+    int page = row / LIST_MODEL_PAGE_SIZE;
+    QList<int> pages = m_pages.keys();
+    for (int i = 0; i < pages.count(); i++) {
+        if (pages[i] >= page) {
+            m_pages.remove(pages[i]);
+            m_pageLru.removeOne(pages[i]);
+        }
+    }
+}
+
 void KdbListModel::clear()
 {
     beginResetModel();
     m_items.clear();
+    m_windowed = false;
+    m_numItems = 0;
+    m_numFetched = 0;
+    m_pages.clear();
+    m_pageLru.clear();
+    m_requestedPages.clear();
     endResetModel();
     m_numGroups = 0;
     m_numEntries = 0;
+    m_hasItemLevels = false;
 
     // signal to QML and for property update
     emit modelDataChanged();
@@ -261,79 +344,306 @@ void KdbListModel::clearListModel()
     clear();
 }
 
-void KdbListModel::slot_appendItemToListModel(QString title, QString subtitle, QString itemId, int itemType, int itemLevel, QString modelId)
+void KdbListModel::slot_appendItemToListModel(QString title, QString subtitle, quint32 itemId, int itemType, int itemLevel, quint32 modelId)
 {
-    if (!m_registered) {
-        m_modelId = modelId;
-        m_registered = true;
+    // in windowed mode changes arrive row wise from the database interface
+    if (m_windowed) return;
+    // only items for this list model are routed here by the database client
+    Q_UNUSED(modelId);
+    KdbItem item(title, subtitle, itemId, itemType, itemLevel);
+    if (itemLevel != 0) {
+        m_hasItemLevels = true;
     }
-    // only append if this item is for us
-    if (m_modelId.compare(modelId) == 0) {
-        KdbItem item(title, subtitle, itemId, itemType, itemLevel);
-        if (itemType == DatabaseItemType::ENTRY) {
-            // append new entry to end of list
-            beginInsertRows(QModelIndex(), rowCount(), rowCount());
-            m_items << item;
-            endInsertRows();
-            m_numEntries++;
-        } else {
-            // insert new group after last group in list
-            int i = 0;
-            while (i < m_items.count() && m_items[i].m_itemType == DatabaseItemType::GROUP) { ++i; }
-            beginInsertRows(QModelIndex(), i, i);
-            m_items.insert(i, item);
-            endInsertRows();
-            m_numGroups++;
+    if (itemType == DatabaseItemType::ENTRY) {
+        // append new entry to end of list
+        beginInsertRows(QModelIndex(), rowCount(), rowCount());
+        m_items << item;
+        endInsertRows();
+        m_numEntries++;
+    } else {
+        // insert new group after last group in list
+        int i = 0;
+        while (i < m_items.count() && m_items[i].m_itemType == DatabaseItemType::GROUP) { ++i; }
+        beginInsertRows(QModelIndex(), i, i);
+        m_items.insert(i, item);
+        endInsertRows();
+        m_numGroups++;
+    }
+    // emit isEmptyChanged signal if list view was empty before
+    if (m_items.length() == 1) {
+        emit isEmptyChanged();
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+}
+
+void KdbListModel::slot_addItemToListModelSorted(QString title, QString subtitle, quint32 itemId, int itemType, int itemLevel, quint32 modelId)
+{
+    // in windowed mode changes arrive row wise from the database interface
+    if (m_windowed) return;
+    // only items for this list model are routed here by the database client
+    Q_UNUSED(modelId);
+    KdbItem item(title, subtitle, itemId, itemType, itemLevel);
+    int i = sortedInsertPosition(item);
+    if (itemLevel != 0) {
+        m_hasItemLevels = true;
+    }
+    if (itemType == DatabaseItemType::ENTRY) {
+        ++m_numEntries;
+    } else {
+        ++m_numGroups;
+    }
+    beginInsertRows(QModelIndex(), i, i);
+    m_items.insert(i, item);
+    endInsertRows();
+    // emit isEmptyChanged signal if list view was empty before
+    if (m_items.length() == 1) {
+        emit isEmptyChanged();
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+}
+
+int KdbListModel::sortedInsertPosition(const KdbItem& item) const
+{
+    // compare and insert alphabetically into list model depending if it is an password entry or group
+    // groups are put at the beginning of the list view before entries
+    int i = 0;
+    int max = 0;
+    if (item.m_itemType == DatabaseItemType::ENTRY) {
+        i = m_numGroups;
+        max = m_items.length();
+    } else {
+        i = 0;
+        max = m_numGroups;
+    }
+    // now find the position in the list model to insert the item sorted by name
+    if (!m_hasItemLevels && item.m_itemLevel == 0) {
+        // all items are on the same level and sorted already, so search binary
+        return qLowerBound(m_items.begin() + i, m_items.begin() + max, item, kdbItemLessThan) - m_items.begin();
+    }
+    // take itemLevel into account so that group names are only compared within the same level
+    while (i < max && (item.m_itemLevel != m_items[i].m_itemLevel || m_items[i].m_sortKey < item.m_sortKey)) {
+        ++i;
+    }
+    return i;
+}
+
+void KdbListModel::insertSorted(const QList<KdbItem>& items)
+{
+    bool hasItemLevels = m_hasItemLevels;
+    for (int i = 0; i < items.count() && !hasItemLevels; i++) {
+        hasItemLevels = (items[i].m_itemLevel != 0);
+    }
+    if (hasItemLevels) {
+        // groups are only compared within the same level, insert them one by one
+        for (int i = 0; i < items.count(); i++) {
+            m_items.insert(sortedInsertPosition(items[i]), items[i]);
+            if (items[i].m_itemType == DatabaseItemType::ENTRY) {
+                ++m_numEntries;
+            } else {
+                ++m_numGroups;
+            }
         }
-        // emit isEmptyChanged signal if list view was empty before
-        if (m_items.length() == 1) {
-            emit isEmptyChanged();
+        m_hasItemLevels = true;
+        return;
+    }
+    // put the new items behind the already sorted groups and entries and sort each part once
+    QList<KdbItem> groups = m_items.mid(0, m_numGroups);
+    QList<KdbItem> entries = m_items.mid(m_numGroups);
+    for (int i = 0; i < items.count(); i++) {
+        if (items[i].m_itemType == DatabaseItemType::ENTRY) {
+            entries << items[i];
+        } else {
+            groups << items[i];
         }
-        // signal to property to update itself in QML
-        emit modelDataChanged();
     }
+    qStableSort(groups.begin(), groups.end(), kdbItemLessThan);
+    qStableSort(entries.begin(), entries.end(), kdbItemLessThan);
+    m_numGroups = groups.count();
+    m_numEntries = entries.count();
+    m_items = groups + entries;
 }
 
-void KdbListModel::slot_addItemToListModelSorted(QString title, QString subtitle, QString itemId, int itemType, int itemLevel, QString modelId)
+void KdbListModel::slot_appendItemsToListModel(QList<KdbItem> items, quint32 modelId)
 {
-    if (!m_registered) {
-        m_modelId = modelId;
-        m_registered = true;
+    Q_UNUSED(modelId);
+    if (items.isEmpty()) {
+        return;
     }
-    // only append if this item is for us
-    if (m_modelId.compare(modelId) == 0) {
-        KdbItem item(title, subtitle, itemId, itemType, itemLevel);
-        // compare and insert alphabetically into list model depending if it is an password entry or group
-        // groups are put at the beginning of the list view before entries
-        int i = 0;
-        int max = 0;
-        if (itemType == DatabaseItemType::ENTRY) {
-            i = m_numGroups;
-            max = m_items.length();
-            ++m_numEntries;
-//            qDebug() << "insert entry i: " << i << " max: " << max << " numEntries: " << m_numEntries << "name: " << title;
+    // groups are put after the last group in the list, entries at the end of the list
+    QList<KdbItem> groups;
+    QList<KdbItem> entries;
+    for (int i = 0; i < items.count(); i++) {
+        if (items[i].m_itemType == DatabaseItemType::ENTRY) {
+            entries << items[i];
         } else {
-            i = 0;
-            max = m_numGroups;
-            ++m_numGroups;
-//            qDebug() << "insert group i: " << i << " max: " << max << " numGroups: " << m_numGroups << "name: " << title;
+            groups << items[i];
         }
-        // now find the position in the list model to insert the item sorted by name
-        // take itemLevel into account so that group names are only compared within the same level
-        while (i < max && (itemLevel != m_items[i].m_itemLevel || m_items[i].m_name.toLower().compare(title.toLower()) < 0)) {
-//        qDebug() << "sort item " << i << " m_name: " << m_items[i].m_name << " =?= " << title << " result: " << m_items[i].m_name.toLower().compare(title.toLower());
-            ++i;
+        if (items[i].m_itemLevel != 0) {
+            m_hasItemLevels = true;
         }
-        beginInsertRows(QModelIndex(), i, i);
-        m_items.insert(i, item);
-        endInsertRows();
-        // emit isEmptyChanged signal if list view was empty before
-        if (m_items.length() == 1) {
-            emit isEmptyChanged();
+    }
+    bool wasEmpty = m_items.isEmpty();
+    if (wasEmpty) {
+        beginResetModel();
+        m_items = groups + entries;
+        endResetModel();
+    } else {
+        if (!groups.isEmpty()) {
+            beginInsertRows(QModelIndex(), m_numGroups, m_numGroups + groups.count() - 1);
+            for (int i = 0; i < groups.count(); i++) {
+                m_items.insert(m_numGroups + i, groups[i]);
+            }
+            endInsertRows();
         }
-        // signal to property to update itself in QML
-        emit modelDataChanged();
+        if (!entries.isEmpty()) {
+            beginInsertRows(QModelIndex(), m_items.count(), m_items.count() + entries.count() - 1);
+            m_items << entries;
+            endInsertRows();
+        }
+    }
+    m_numGroups += groups.count();
+    m_numEntries += entries.count();
+
+    if (wasEmpty) {
+        emit isEmptyChanged();
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+}
+
+void KdbListModel::slot_addItemsToListModelSorted(QList<KdbItem> items, quint32 modelId)
+{
+    Q_UNUSED(modelId);
+    if (items.isEmpty()) {
+        return;
+    }
+    bool wasEmpty = m_items.isEmpty();
+    // the items are sorted in one go and the view is reset only once afterwards
+    beginResetModel();
+    insertSorted(items);
+    endResetModel();
+
+    if (wasEmpty) {
+        emit isEmptyChanged();
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+}
+
+void KdbListModel::slot_listModelWindowLoaded(QList<KdbItem> firstPage, int numItems, quint32 modelId)
+{
+    Q_UNUSED(modelId);
+    bool wasEmpty = isEmpty();
+    beginResetModel();
+    m_items.clear();
+    m_numGroups = 0;
+    m_numEntries = 0;
+    m_hasItemLevels = false;
+    m_windowed = true;
+    m_numItems = numItems;
+    m_numFetched = qMin(firstPage.count(), numItems);
+    m_pages.clear();
+    m_pageLru.clear();
+    m_requestedPages.clear();
+    m_pages.insert(0, firstPage);
+    m_pageLru.prepend(0);
+    endResetModel();
+
+    if (wasEmpty != isEmpty()) {
+        emit isEmptyChanged();
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+}
+
+void KdbListModel::slot_listModelPageLoaded(int firstRow, QList<KdbItem> items, quint32 modelId)
+{
+    Q_UNUSED(modelId);
+    if (!m_windowed) {
+        return;
+    }
+    int page = firstRow / LIST_MODEL_PAGE_SIZE;
+    m_requestedPages.remove(page);
+    m_pages.insert(page, items);
+    m_pageLru.removeOne(page);
+    m_pageLru.prepend(page);
+    while (m_pageLru.count() > MAX_CACHED_PAGES) {
+        m_pages.remove(m_pageLru.takeLast());
+    }
+
+    int lastRow = qMin(firstRow + items.count(), m_numItems) - 1;
+    int numShown = m_numFetched;
+    if (lastRow >= m_numFetched) {
+        // page reaches behind the shown rows, so fetchMore() asked for it
+        beginInsertRows(QModelIndex(), m_numFetched, lastRow);
+        m_numFetched = lastRow + 1;
+        endInsertRows();
+    }
+    if (firstRow < numShown) {
+        // rows which were shown with empty content before
+        emit dataChanged(index(firstRow), index(qMin(lastRow, numShown - 1)));
+    }
+}
+
+void KdbListModel::slot_itemInsertedInListModelWindow(int row, quint32 modelId)
+{
+    Q_UNUSED(modelId);
+    if (!m_windowed) {
+        return;
+    }
+    bool allFetched = (m_numFetched == m_numItems);
+    ++m_numItems;
+    invalidatePagesFrom(row);
+    // rows which are not shown yet are added later on with fetchMore()
+    if (row < m_numFetched || allFetched) {
+        beginInsertRows(QModelIndex(), row, row);
+        ++m_numFetched;
+        endInsertRows();
+    }
+    if (m_numItems == 1) {
+        emit isEmptyChanged();
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+}
+
+void KdbListModel::slot_itemRemovedFromListModelWindow(int row, quint32 modelId)
+{
+    Q_UNUSED(modelId);
+    if (!m_windowed) {
+        return;
+    }
+    --m_numItems;
+    invalidatePagesFrom(row);
+    if (row < m_numFetched) {
+        beginRemoveRows(QModelIndex(), row, row);
+        --m_numFetched;
+        endRemoveRows();
+    }
+    if (m_numItems == 0) {
+        emit isEmptyChanged();
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+}
+
+void KdbListModel::slot_itemChangedInListModelWindow(int row, quint32 modelId)
+{
+    Q_UNUSED(modelId);
+    if (!m_windowed) {
+        return;
+    }
+    // drop the page with the old content, it is loaded again when the view asks for the row
+    int page = row / LIST_MODEL_PAGE_SIZE;
+    m_pages.remove(page);
+    m_pageLru.removeOne(page);
+    if (row < m_numFetched) {
+        emit dataChanged(index(row), index(row));
     }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
 }
 
 /******************************************************************************
@@ -345,49 +655,48 @@ This function updates a single groups item in the list model data.
 \param groupId Identifier for the item inside of the list model.
 \param modelId Identifier for list model, which needs to be changed.
 ******************************************************************************/
-void KdbListModel::slot_updateItemInListModel(QString title, QString subTitle, QString itemId, QString modelId)
-{
-    // check if we need to do anything
-    if (m_modelId.compare(modelId) == 0) {
-        // look at each item in list model
-        for (int i = 0; i < m_items.count(); i++) {
-            if (m_items[i].m_id == itemId) {
-//                qDebug() << "adding in non sorted mode: " << title;
-                // list view has custom sorting so position of item will stay the same and item just needs an update
-                beginResetModel();
-                // set new title name
-                m_items[i].m_name = title;
-                m_items[i].m_subtitle = subTitle;
-                endResetModel();
-            }
+void KdbListModel::slot_updateItemInListModel(QString title, QString subTitle, quint32 itemId, quint32 modelId)
+{
+    if (m_windowed) return;
+    // only items for this list model are routed here by the database client
+    Q_UNUSED(modelId);
+    // look at each item in list model
+    for (int i = 0; i < m_items.count(); i++) {
+        if (m_items[i].m_id == itemId) {
+//            qDebug() << "adding in non sorted mode: " << title;
+            // list view has custom sorting so position of item will stay the same and item just needs an update
+            beginResetModel();
+            // set new title name
+            m_items[i].setName(title);
+            m_items[i].m_subtitle = subTitle;
+            endResetModel();
         }
-        // signal to property to update itself in QML
-        emit modelDataChanged();
-    }
-}
-
-void KdbListModel::slot_updateItemInListModelSorted(QString title, QString subTitle, QString itemId, QString modelId)
-{
-    // check if we need to do anything
-    if (m_modelId.compare(modelId) == 0) {
-        // look at each item in list model
-        for (int i = 0; i < m_items.count(); i++) {
-            if (m_items[i].m_id == itemId) {
-                // list view is sorted alphabetically so a new title might change the position of the item
-                // remove and insert item again, this makes sure that the new item will appear
-                // in the correct position in the alphabetically sorted list view
-//                qDebug() << "adding in sorted mode: " << title;
-                int itemType = m_items[i].m_itemType;
-                int itemLevel = m_items[i].m_itemLevel;
-                slot_deleteItem(itemId);
-                slot_addItemToListModelSorted(title, subTitle, itemId, itemType, itemLevel, modelId);
-            }
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+}
+
+void KdbListModel::slot_updateItemInListModelSorted(QString title, QString subTitle, quint32 itemId, quint32 modelId)
+{
+    if (m_windowed) return;
+    // look at each item in list model
+    for (int i = 0; i < m_items.count(); i++) {
+        if (m_items[i].m_id == itemId) {
+            // list view is sorted alphabetically so a new title might change the position of the item
+            // remove and insert item again, this makes sure that the new item will appear
+            // in the correct position in the alphabetically sorted list view
+//            qDebug() << "adding in sorted mode: " << title;
+            int itemType = m_items[i].m_itemType;
+            int itemLevel = m_items[i].m_itemLevel;
+            slot_deleteItem(itemId);
+            slot_addItemToListModelSorted(title, subTitle, itemId, itemType, itemLevel, modelId);
         }
     }
 }
 
-void KdbListModel::slot_deleteItem(QString itemId)
+void KdbListModel::slot_deleteItem(quint32 itemId)
 {
+    if (m_windowed) return;
     // look at each item in list model
     for (int i = 0; i < m_items.count(); i++) {
         if (m_items[i].m_id == itemId) {
@@ -412,6 +721,43 @@ void KdbListModel::slot_deleteItem(QString itemId)
     }
 }
 
+void KdbListModel::slot_deleteItems(QList<quint32> itemIds, quint32 modelId)
+{
+    if (m_windowed) return;
+    // only items for this list model are routed here by the database client
+    Q_UNUSED(modelId);
+    if (itemIds.isEmpty() || m_items.isEmpty()) return;
+    QSet<quint32> ids = itemIds.toSet();
+    // go backwards so that the rows of the items which are still to be checked do not change
+    for (int i = m_items.count() - 1; i >= 0; i--) {
+        if (ids.contains(m_items[i].m_id)) {
+            if (m_items[i].m_itemType == DatabaseItemType::ENTRY) {
+                m_numEntries--;
+            } else {
+                m_numGroups--;
+            }
+            beginRemoveRows(QModelIndex(), i, i);
+            m_items.removeAt(i);
+            endRemoveRows();
+        }
+    }
+    // signal to property to update itself in QML
+    emit modelDataChanged();
+    // emit isEmptyChanged signal if last item was deleted
+    if (m_items.isEmpty()) {
+        emit isEmptyChanged();
+    }
+}
+
+void KdbListModel::slot_clearListModel(quint32 modelId)
+{
+    // only items for this list model are routed here by the database client
+    Q_UNUSED(modelId);
+    if (!isEmpty()) {
+        clear();
+    }
+}
+
 void KdbListModel::slot_disconnectFromDatabaseClient()
 {
     if (m_connected) {
@@ -25,6 +25,7 @@
 
 #include <QAbstractListModel>
 #include <QStringList>
+#include <QSet>
 #include "private/AbstractDatabaseInterface.h"
 
 
@@ -35,8 +36,14 @@ static const int baseRole = Qt::UserRole + 1;
 class KdbItem
 {
 public:
-    KdbItem(QString name, QString subtitle, QString id, int itemType, int itemLevel)
+    KdbItem()
+        : m_id(0),
+          m_itemType(0),
+          m_itemLevel(0)
+    {}
+    KdbItem(QString name, QString subtitle, quint32 id, int itemType, int itemLevel)
         : m_name(name),
+          m_sortKey(sortKey(name)),
           m_subtitle(subtitle),
           m_id(id),
           m_itemType(itemType),
@@ -46,10 +53,14 @@ public:
 
     QVariant get(const int role) const;
     static QHash<int, QByteArray> createRoles();
+    // key for sorting items alphabetically by name, computed once per item instead of on each comparison
+    static QString sortKey(const QString& name) { return name.toCaseFolded(); }
+    void setName(const QString& name) { m_name = name; m_sortKey = sortKey(name); }
 
     QString m_name;
+    QString m_sortKey;
     QString m_subtitle;
-    QString m_id;
+    quint32 m_id;
     int m_itemType;
     int m_itemLevel;
 };
@@ -60,12 +71,12 @@ class KdbListModel : public QAbstractListModel
 
 public:
     Q_PROPERTY(bool isEmpty READ isEmpty NOTIFY isEmptyChanged)
-    Q_PROPERTY(QString searchRootGroupId READ getSearchRootGroupId WRITE setSearchRootGroupId STORED true SCRIPTABLE true)
+    Q_PROPERTY(quint32 searchRootGroupId READ getSearchRootGroupId WRITE setSearchRootGroupId STORED true SCRIPTABLE true)
 
 public:
     Q_INVOKABLE void loadMasterGroupsFromDatabase();
     Q_INVOKABLE void loadGroupListFromDatabase();
-    Q_INVOKABLE void loadGroupsAndEntriesFromDatabase(QString groupId);
+    Q_INVOKABLE void loadGroupsAndEntriesFromDatabase(quint32 groupId);
     Q_INVOKABLE void searchEntriesInKdbDatabase(QString searchString);
     Q_INVOKABLE void clearListModel();
 
@@ -75,10 +86,12 @@ public:
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
     void clear();
     bool isEmpty();
-    QString getSearchRootGroupId() const { return m_searchRootGroupId; }
-    void setSearchRootGroupId(const QString groupId) { m_searchRootGroupId = groupId; }
+    quint32 getSearchRootGroupId() const { return m_searchRootGroupId; }
+    void setSearchRootGroupId(quint32 groupId) { m_searchRootGroupId = groupId; }
 
     // Overwrite function to set role names
     virtual QHash<int, QByteArray> roleNames() const { return KdbItem::createRoles(); }
@@ -86,9 +99,10 @@ public:
 signals:
     // signals to database client
     void loadMasterGroups(bool registerListModel);
-    void loadGroupsAndEntries(QString groupId);
-    void unregisterFromDatabaseClient(QString modelId);
-    void searchEntries(QString searchString, QString rootGroupId);
+    void loadGroupsAndEntries(quint32 groupId);
+    void unregisterFromDatabaseClient(quint32 modelId);
+    void searchEntries(QString searchString, quint32 rootGroupId);
+    void loadListModelPage(quint32 modelId, int firstRow, int count) const;
 
     // signals to QML
     void groupsAndEntriesLoaded(int result);
@@ -101,30 +115,54 @@ signals:
 
 public slots:
     // signal from database client
-    void slot_appendItemToListModel(QString title, QString subtitle, QString itemId, int itemType, int itemLevel, QString modelId);
-    void slot_addItemToListModelSorted(QString title, QString subtitle, QString itemId, int itemType, int itemLevel, QString modelId);
-    void slot_updateItemInListModel(QString title, QString subTitle, QString itemId, QString modelId);
-    void slot_updateItemInListModelSorted(QString title, QString subTitle, QString itemId, QString modelId);
-    void slot_deleteItem(QString itemId);
+    void slot_appendItemToListModel(QString title, QString subtitle, quint32 itemId, int itemType, int itemLevel, quint32 modelId);
+    void slot_addItemToListModelSorted(QString title, QString subtitle, quint32 itemId, int itemType, int itemLevel, quint32 modelId);
+    void slot_appendItemsToListModel(QList<kpxPublic::KdbItem> items, quint32 modelId);
+    void slot_addItemsToListModelSorted(QList<kpxPublic::KdbItem> items, quint32 modelId);
+    void slot_listModelWindowLoaded(QList<kpxPublic::KdbItem> firstPage, int numItems, quint32 modelId);
+    void slot_listModelPageLoaded(int firstRow, QList<kpxPublic::KdbItem> items, quint32 modelId);
+    void slot_itemInsertedInListModelWindow(int row, quint32 modelId);
+    void slot_itemRemovedFromListModelWindow(int row, quint32 modelId);
+    void slot_itemChangedInListModelWindow(int row, quint32 modelId);
+    void slot_updateItemInListModel(QString title, QString subTitle, quint32 itemId, quint32 modelId);
+    void slot_updateItemInListModelSorted(QString title, QString subTitle, quint32 itemId, quint32 modelId);
+    void slot_deleteItem(quint32 itemId);
+    void slot_deleteItems(QList<quint32> itemIds, quint32 modelId);
+    void slot_clearListModel(quint32 modelId);
     void slot_disconnectFromDatabaseClient();
 
 private:
     bool connectToDatabaseClient();
     void disconnectFromDatabaseClient();
+    int sortedInsertPosition(const KdbItem& item) const;
+    void insertSorted(const QList<KdbItem>& items);
+    void requestPage(int page) const;
+    void invalidatePagesFrom(int row);
 
 private:
     QList<KdbItem> m_items;
     // identifier for this list model
-    QString m_modelId;
+    quint32 m_modelId;
     // number of groups and items in the list view
     int m_numGroups;
     int m_numEntries;
+    // set if items of different levels are in the list, then groups are not sorted as a whole
+    bool m_hasItemLevels;
     // indicator if this list model has registered at the global keepass database object
     bool m_registered;
     // identifier of the group from which a search for entries should be performed
-    QString m_searchRootGroupId;
+    quint32 m_searchRootGroupId;
     // identifies if this object is conntected to a loaded keepass database
     bool m_connected;
+    // In windowed mode the item ids of big groups and search results are kept by the database interface
+    // in the worker thread. Only m_numFetched of m_numItems rows are shown so far, more are added with
+    // fetchMore(). The items are held page wise in a small LRU cache, most recently used page first.
+    bool m_windowed;
+    int m_numItems;
+    int m_numFetched;
+    mutable QHash<int, QList<KdbItem> > m_pages;
+    mutable QList<int> m_pageLru;
+    mutable QSet<int> m_requestedPages;
 };
 
 // inline implementations
@@ -158,4 +196,6 @@ inline QHash<int, QByteArray> KdbItem::createRoles()
 
 }
 
+Q_DECLARE_METATYPE(kpxPublic::KdbItem)
+
 #endif // KDBLISTMODEL_H
@@ -36,6 +36,7 @@ SOURCES += \
     ../common/src/keepassPlugin/databaseInterface/private/Keepass2DatabaseFactory.cpp \
     ../common/src/keepassPlugin/databaseInterface/private/Keepass1DatabaseInterface.cpp \
     ../common/src/keepassPlugin/databaseInterface/private/Keepass2DatabaseInterface.cpp \
+    ../common/src/keepassPlugin/databaseInterface/private/SearchIndex.cpp \
 
 HEADERS += \
     ../common/src/keepassPlugin/databaseInterface/KdbDatabase.h \
@@ -47,6 +48,10 @@ HEADERS += \
     ../common/src/keepassPlugin/databaseInterface/private/Keepass1DatabaseFactory.h \
     ../common/src/keepassPlugin/databaseInterface/private/Keepass2DatabaseFactory.h \
     ../common/src/keepassPlugin/databaseInterface/private/AbstractDatabaseInterface.h \
+    ../common/src/keepassPlugin/databaseInterface/private/ItemHandleTable.h \
+    ../common/src/keepassPlugin/databaseInterface/private/ListModelRegistry.h \
+    ../common/src/keepassPlugin/databaseInterface/private/SearchIndex.h \
+    ../common/src/keepassPlugin/databaseInterface/private/StageTimer.h \
     ../common/src/keepassPlugin/databaseInterface/private/Keepass1DatabaseInterface.h \
     ../common/src/keepassPlugin/databaseInterface/private/Keepass2DatabaseInterface.h \
 
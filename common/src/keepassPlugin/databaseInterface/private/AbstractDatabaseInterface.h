@@ -24,7 +24,83 @@
 #define DATABASEINTERFACE_H
 
 #include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVariantList>
 
+namespace kpxPublic {
+class KdbItem;
+}
+
+namespace kpxPrivate {
+
+// Groups and search results with more items than this are not sent to the
+// list model as a whole but page by page (see listModelWindowLoaded())
+static const int LIST_MODEL_WINDOW_THRESHOLD = 200;
+// Number of items in one page of such a list model
+static const int LIST_MODEL_PAGE_SIZE = 50;
+
+// time in milliseconds in which changes on the database are collected before they are saved
+static const int SAVE_COALESCING_TIME = 500;
+
+// Number of entries which are checked by a search before the worker thread handles other requests
+static const int SEARCH_CHUNK_SIZE = 250;
+
+// Ordered item ids of a list model which is filled page by page. It is kept
+// by the database interface in the worker thread, groups come before entries.
+struct ListModelWindow
+{
+    ListModelWindow() : numGroups(0) {}
+    QList<quint32> itemIds;
+    int numGroups;
+};
+
+// Used to sort the entries of a ListModelWindow alphabetically in the same way as the list model does it
+struct ListModelSortKey
+{
+    QString title;  // KdbItem::sortKey() of the title
+    quint32 itemId;
+    bool operator<(const ListModelSortKey& other) const { return title < other.title; }
+};
+
+// Result of the last search. If the next search string contains the last one, it finds a subset of these
+// entries, so only they need to be checked again. It gets invalid when entries or groups are changed.
+struct SearchSession
+{
+    SearchSession() : valid(false), rootGroupId(0) {}
+    bool isRefinedBy(const QString& newSearchString, quint32 newRootGroupId) const
+    {
+        return valid && !searchString.isEmpty() && newRootGroupId == rootGroupId &&
+                newSearchString.toCaseFolded().contains(searchString.toCaseFolded());
+    }
+    bool valid;
+    QString searchString;
+    quint32 rootGroupId;
+    QList<quint32> itemIds;
+};
+
+// A search which runs in chunks of SEARCH_CHUNK_SIZE entries. Each search request gets a new generation,
+// chunks of an older generation are dropped, so that a new search string replaces a running search.
+struct SearchJob
+{
+    SearchJob() : generation(0), running(false), started(false), rootGroupId(0), position(0), databaseChanged(false) {}
+    uint generation;
+    bool running;
+    // candidates are looked up with the first chunk
+    bool started;
+    QString searchString;
+    quint32 rootGroupId;
+    QStringList words;
+    QList<quint32> candidates;
+    // index of the next candidate to check
+    int position;
+    // found entries in the order they were found
+    QList<quint32> itemIds;
+    // entries or groups were changed while searching, the result cannot be refined then
+    bool databaseChanged;
+};
+
+}
 
 // Interface for accessing a database
 class AbstractDatabaseInterface
@@ -75,17 +151,37 @@ protected: // signals
     virtual void passwordChanged() = 0;
     virtual void databaseKeyTransfRoundsChanged(int value) = 0;
     virtual void databaseCryptAlgorithmChanged(int value) = 0;
+    /*!
+     * \brief The keyTransfRoundsCalibrated() signal is emitted after calling
+     * slot_calibrateKeyTransfRounds().
+     *
+     * \param rounds is the number of key transformation rounds which take
+     *        the requested time to open a database on this device.
+     * \param openTime is the predicted time in milliseconds for the key
+     *        transformation of the currently opened database or -1 if no
+     *        database is opened.
+     */
+    virtual void keyTransfRoundsCalibrated(int rounds, int openTime) = 0;
+    /*!
+     * \brief The stagesTimed() signal is emitted after the database was
+     * opened, saved or searched if stage timing is enabled with
+     * slot_setting_stageTiming().
+     *
+     * \param operation is "open", "save" or "search".
+     * \param stages contains one QVariantMap per stage in the order in which
+     *        they were run. It has the keys "name", "nsecs" (duration of the
+     *        stage in nanoseconds) and "bytes" (number of bytes processed in
+     *        the stage or 0 if not applicable).
+     */
+    virtual void stagesTimed(QString operation, QVariantList stages) = 0;
     /*!
      * \brief The errorOccured() signal is emitted whenever an internal error
      * occured. Refer to the result list for the severity of the error and if
      * accessing the database is still possible.
      *
      * \param result is one from the folloing list:
-     *        RE_ERR_QSTRING_TO_UUID QString value is not exactly 16 characters
-     *          long and cannot be converted successfully (Keepass 2 only)
-     *          Access to database is still possible. Severity low.
-     *        RE_ERR_QSTRING_TO_INT Conversion from QString to integer number
-     *          failed (Keepass 1 only)
+     *        RE_ERR_ITEM_NOT_FOUND A group or entry ID does not refer to an
+     *          existing item (anymore), errorMsg holds the ID in hexadecimal
      *          Access to database is still possible. Severity low.
      *        RE_CRYPTO_INIT_ERROR Cryptographic algorithms could not be
      *          initialized successfully, abort opening of any Keepass database
@@ -98,55 +194,103 @@ protected: // signals
     // signals to KdbListModel object
     virtual void appendItemToListModel(QString title,
                                        QString subtitle,
-                                       QString itemId,
+                                       quint32 itemId,
                                        int itemType,
                                        int itemLevel,
-                                       QString modelId) = 0;
+                                       quint32 modelId) = 0;
     virtual void addItemToListModelSorted(QString title,
                                           QString subtitle,
-                                          QString itemId,
+                                          quint32 itemId,
                                           int itemType,
                                           int itemLevel,
-                                          QString modelId) = 0;
+                                          quint32 modelId) = 0;
+    /*!
+     * \brief The appendItemsToListModel() and addItemsToListModelSorted()
+     * signals deliver all groups and entries of a list model at once, e.g.
+     * after slot_loadGroupsAndEntries() or slot_searchEntries(). They are
+     * only emitted if there is at least one item. The list model inserts them
+     * like the single item variants above but updates the view only once.
+     */
+    virtual void appendItemsToListModel(QList<kpxPublic::KdbItem> items,
+                                        quint32 modelId) = 0;
+    virtual void addItemsToListModelSorted(QList<kpxPublic::KdbItem> items,
+                                           quint32 modelId) = 0;
+    /*!
+     * \brief The listModelWindowLoaded() signal is emitted instead of
+     * appendItemsToListModel() if a group or search result has more than
+     * LIST_MODEL_WINDOW_THRESHOLD items. It delivers only the first page and
+     * the total number of items. Further pages are requested by the list
+     * model with slot_loadListModelPage() and are delivered with
+     * listModelPageLoaded(). Changes in such a list model are signalled by
+     * row with the itemInserted/Removed/ChangedInListModelWindow() signals,
+     * the item based signals above are ignored by the list model then.
+     */
+    virtual void listModelWindowLoaded(QList<kpxPublic::KdbItem> firstPage,
+                                       int numItems,
+                                       quint32 modelId) = 0;
+    virtual void listModelPageLoaded(int firstRow,
+                                     QList<kpxPublic::KdbItem> items,
+                                     quint32 modelId) = 0;
+    virtual void itemInsertedInListModelWindow(int row,
+                                               quint32 modelId) = 0;
+    virtual void itemRemovedFromListModelWindow(int row,
+                                                quint32 modelId) = 0;
+    virtual void itemChangedInListModelWindow(int row,
+                                              quint32 modelId) = 0;
     virtual void updateItemInListModel(QString title,
                                        QString subTitle,
-                                       QString itemId,
-                                       QString modelId) = 0;
+                                       quint32 itemId,
+                                       quint32 modelId) = 0;
     virtual void updateItemInListModelSorted(QString title,
                                              QString subTitle,
-                                             QString itemId,
-                                             QString modelId) = 0;
+                                             quint32 itemId,
+                                             quint32 modelId) = 0;
     virtual void masterGroupsLoaded(int result) = 0;
     virtual void groupsAndEntriesLoaded(int result) = 0;
-    virtual void deleteItemInListModel(QString itemId) = 0;
+    virtual void deleteItemInListModel(quint32 itemId,
+                                       QList<quint32> modelIds) = 0;
+    /*!
+     * \brief The deleteItemsInListModel() and clearListModel() signals are
+     * used by slot_searchEntries() to update the search list model. If the
+     * new search string contains the last one only the entries which do not
+     * match anymore are deleted, otherwise the list model is cleared before
+     * the new result is sent.
+     */
+    virtual void deleteItemsInListModel(QList<quint32> itemIds,
+                                        quint32 modelId) = 0;
+    virtual void clearListModel(quint32 modelId) = 0;
     virtual void searchEntriesCompleted(int result) = 0;
 
     // signal to KdbEntry object
+    // The result of the signals for changed, created, deleted and moved entries and groups
+    // refers to the database in memory. The database file is written after SAVE_COALESCING_TIME
+    // together with all other changes done in the meantime. If that fails errorOccured() is
+    // emitted with RE_DB_SAVE_ERROR. Only read only databases give RE_DB_SAVE_ERROR right away.
     virtual void entryLoaded(int result,
-                             QString entryId,
+                             quint32 entryId,
                              QList<QString> keys,
                              QList<QString> values) = 0;
     virtual void entrySaved(int result,
-                            QString entryId) = 0;
+                            quint32 entryId) = 0;
     virtual void newEntryCreated(int result,
-                                 QString entryId) = 0;
+                                 quint32 entryId) = 0;
     virtual void entryDeleted(int result,
-                              QString entryId) = 0;
+                              quint32 entryId) = 0;
     virtual void entryMoved(int result,
-                            QString entryId) = 0;
+                            quint32 entryId) = 0;
 
     // signal to KdbGroup object
     virtual void groupLoaded(int result,
-                             QString groupId,
+                             quint32 groupId,
                              QString title) = 0;
     virtual void groupSaved(int result,
-                            QString groupId) = 0;
+                            quint32 groupId) = 0;
     virtual void newGroupCreated(int result,
-                                 QString groupId) = 0;
+                                 quint32 groupId) = 0;
     virtual void groupDeleted(int result,
-                              QString groupId) = 0;
+                              quint32 groupId) = 0;
     virtual void groupMoved(int result,
-                            QString groupId) = 0;
+                            quint32 groupId) = 0;
 
 
 public: // slots
@@ -161,23 +305,42 @@ public: // slots
                                         int cryptAlgorithm,
                                         int keyTransfRounds) = 0;
     virtual void slot_closeDatabase() = 0;
+    // Writes changes which are still waiting to be saved. DatabaseClient calls this in the worker thread
+    // before the thread is stopped, i.e. when the application quits.
+    virtual void slot_flushPendingChanges() = 0;
     virtual void slot_changePassKey(QString password,
                                     QString keyFile) = 0;
+    // A negative keyTransfRounds value for slot_createNewDatabase() and
+    // slot_changeKeyTransfRounds() means that the rounds are calibrated
+    // on this device to take -value milliseconds for opening the database
     virtual void slot_changeKeyTransfRounds(int value) = 0;
+    virtual void slot_calibrateKeyTransfRounds(int targetTime) = 0;
     virtual void slot_changeCryptAlgorithm(int value) = 0;
     virtual void slot_setting_showUserNamePasswordsInListView(bool value) = 0;
     virtual void slot_setting_sortAlphabeticallyInListView(bool value) = 0;
+    // Timing of the stages of open, save and search, see stagesTimed(). Disabled by default.
+    virtual void slot_setting_stageTiming(bool value) = 0;
 
     // signal from KdbListModel object
     virtual void slot_loadMasterGroups(bool registerListModel) = 0;
-    virtual void slot_loadGroupsAndEntries(QString groupId) = 0;
-    virtual void slot_unregisterListModel(QString modelId) = 0;
+    virtual void slot_loadGroupsAndEntries(quint32 groupId) = 0;
+    virtual void slot_unregisterListModel(quint32 modelId) = 0;
+    virtual void slot_loadListModelPage(quint32 modelId,
+                                        int firstRow,
+                                        int count) = 0;
+    /*!
+     * \brief Search requests are not handled right away but when the requests
+     * which are already queued are done. The search runs in chunks, between
+     * them other requests are handled and a new search request replaces the
+     * running one. Found entries are sent to the search list model after each
+     * chunk, searchEntriesCompleted() is emitted when the search is finished.
+     */
     virtual void slot_searchEntries(QString searchString,
-                                    QString rootGroupId) = 0;
+                                    quint32 rootGroupId) = 0;
 
     // signal from KdbEntry object
-    virtual void slot_loadEntry(QString entryId) = 0;
-    virtual void slot_saveEntry(QString entryId,
+    virtual void slot_loadEntry(quint32 entryId) = 0;
+    virtual void slot_saveEntry(quint32 entryId,
                         QString title,
                         QString url,
                         QString username,
@@ -188,21 +351,21 @@ public: // slots
                              QString username,
                              QString password,
                              QString comment,
-                             QString parentGroupId) = 0;
-    virtual void slot_deleteEntry(QString entryId) = 0;
-    virtual void slot_moveEntry(QString entryId,
-                                QString newGroupId) = 0;
+                             quint32 parentGroupId) = 0;
+    virtual void slot_deleteEntry(quint32 entryId) = 0;
+    virtual void slot_moveEntry(quint32 entryId,
+                                quint32 newGroupId) = 0;
 
     // signal from KdbGroup object
-    virtual void slot_loadGroup(QString groupId) = 0;
-    virtual void slot_saveGroup(QString groupId,
+    virtual void slot_loadGroup(quint32 groupId) = 0;
+    virtual void slot_saveGroup(quint32 groupId,
                                 QString title) = 0;
     virtual void slot_createNewGroup(QString title,
                                      quint32 iconId,
-                                     QString parentGroupId) = 0;
-    virtual void slot_deleteGroup(QString groupId) = 0;
-    virtual void slot_moveGroup(QString groupId,
-                                QString newParentGroupId) = 0;
+                                     quint32 parentGroupId) = 0;
+    virtual void slot_deleteGroup(quint32 groupId) = 0;
+    virtual void slot_moveGroup(quint32 groupId,
+                                quint32 newParentGroupId) = 0;
 };
 
 Q_DECLARE_INTERFACE(AbstractDatabaseInterface, "harbour.ownkeepass.AbstractDatabaseInterface")
@@ -20,12 +20,16 @@
 **
 ***************************************************************************/
 
+#include <QCoreApplication>
+
 #include "DatabaseClient.h"
 #include "Keepass1DatabaseFactory.h"
 #include "Keepass2DatabaseFactory.h"
 #include "ownKeepassGlobal.h"
+#include "../KdbListModel.h"
 
 using namespace kpxPrivate;
+using namespace kpxPublic;
 using namespace ownKeepassPublic;
 
 // Global static pointer used to ensure a single instance of the class
@@ -42,6 +46,10 @@ DatabaseClient::DatabaseClient(QObject *parent)
 
 int DatabaseClient::initDatabaseInterface(const int type)
 {
+    // needed to pass batches of list model items and item IDs from the worker thread to the list models
+    qRegisterMetaType<QList<kpxPublic::KdbItem> >("QList<kpxPublic::KdbItem>");
+    qRegisterMetaType<QList<quint32> >("QList<quint32>");
+
     if (m_initialized) {
         closeDatabaseInterface();
     }
@@ -69,14 +77,31 @@ int DatabaseClient::initDatabaseInterface(const int type)
 
     // DatabaseInterface object m_worker is also a QObject, so in order to use functions from it cast it before
     dynamic_cast<QObject*>(m_interface)->moveToThread(&m_workerThread);
+    connectListModelSignals();
     m_workerThread.start();
 
+    // The singleton is never deleted, so changes which are not saved yet are written when the application quits.
+    // Connecting again after the interface was reinitialized does nothing because of Qt::UniqueConnection.
+    connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()),
+            this, SLOT(slot_flushPendingChanges()), Qt::UniqueConnection);
+
     return 0;
 }
 
+void DatabaseClient::slot_flushPendingChanges()
+{
+    // the save runs in the worker thread, where the database objects live, and is waited for
+    if (m_initialized && m_workerThread.isRunning()) {
+        bool ret = QMetaObject::invokeMethod(dynamic_cast<QObject*>(m_interface), "slot_flushPendingChanges",
+                                             Qt::BlockingQueuedConnection);
+        Q_ASSERT(ret);
+    }
+}
+
 void DatabaseClient::closeDatabaseInterface()
 {
-    // first terminate background thread
+    // write pending changes, then terminate background thread
+    slot_flushPendingChanges();
     if (m_workerThread.isRunning()) {
         m_workerThread.quit();
         m_workerThread.wait();
@@ -105,3 +130,212 @@ DatabaseClient* DatabaseClient::getInstance()
     Q_ASSERT(m_Instance);
     return m_Instance;
 }
+
+void DatabaseClient::connectListModelSignals()
+{
+    // items for list models are received here and passed on only to the list models which subscribed for them
+    QObject* interface = dynamic_cast<QObject*>(m_interface);
+    bool ret = connect(interface,
+                       SIGNAL(appendItemToListModel(QString, QString, quint32, int, int, quint32)),
+                       this,
+                       SLOT(slot_appendItemToListModel(QString, QString, quint32, int, int, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(addItemToListModelSorted(QString, QString, quint32, int, int, quint32)),
+                  this,
+                  SLOT(slot_addItemToListModelSorted(QString, QString, quint32, int, int, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(appendItemsToListModel(QList<kpxPublic::KdbItem>, quint32)),
+                  this,
+                  SLOT(slot_appendItemsToListModel(QList<kpxPublic::KdbItem>, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(addItemsToListModelSorted(QList<kpxPublic::KdbItem>, quint32)),
+                  this,
+                  SLOT(slot_addItemsToListModelSorted(QList<kpxPublic::KdbItem>, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(listModelWindowLoaded(QList<kpxPublic::KdbItem>, int, quint32)),
+                  this,
+                  SLOT(slot_listModelWindowLoaded(QList<kpxPublic::KdbItem>, int, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(listModelPageLoaded(int, QList<kpxPublic::KdbItem>, quint32)),
+                  this,
+                  SLOT(slot_listModelPageLoaded(int, QList<kpxPublic::KdbItem>, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(itemInsertedInListModelWindow(int, quint32)),
+                  this,
+                  SLOT(slot_itemInsertedInListModelWindow(int, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(itemRemovedFromListModelWindow(int, quint32)),
+                  this,
+                  SLOT(slot_itemRemovedFromListModelWindow(int, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(itemChangedInListModelWindow(int, quint32)),
+                  this,
+                  SLOT(slot_itemChangedInListModelWindow(int, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(updateItemInListModel(QString, QString, quint32, quint32)),
+                  this,
+                  SLOT(slot_updateItemInListModel(QString, QString, quint32, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(updateItemInListModelSorted(QString, QString, quint32, quint32)),
+                  this,
+                  SLOT(slot_updateItemInListModelSorted(QString, QString, quint32, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(deleteItemInListModel(quint32, QList<quint32>)),
+                  this,
+                  SLOT(slot_deleteItemInListModel(quint32, QList<quint32>)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(deleteItemsInListModel(QList<quint32>, quint32)),
+                  this,
+                  SLOT(slot_deleteItemsInListModel(QList<quint32>, quint32)));
+    Q_ASSERT(ret);
+    ret = connect(interface,
+                  SIGNAL(clearListModel(quint32)),
+                  this,
+                  SLOT(slot_clearListModel(quint32)));
+    Q_ASSERT(ret);
+}
+
+void DatabaseClient::subscribeListModel(quint32 modelId, KdbListModel* listModel)
+{
+    unsubscribeListModel(listModel);
+    m_listModels.insert(modelId, listModel);
+    m_listModelIds.insert(listModel, modelId);
+}
+
+void DatabaseClient::unsubscribeListModel(KdbListModel* listModel)
+{
+    QHash<KdbListModel*, quint32>::iterator it = m_listModelIds.find(listModel);
+    if (it != m_listModelIds.end()) {
+        m_listModels.remove(it.value(), listModel);
+        m_listModelIds.erase(it);
+    }
+}
+
+// The list models are looked up before any of them is called, because a list model
+// might subscribe or unsubscribe while it is handling the items
+
+void DatabaseClient::slot_appendItemToListModel(QString title, QString subtitle, quint32 itemId, int itemType, int itemLevel, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_appendItemToListModel(title, subtitle, itemId, itemType, itemLevel, modelId);
+    }
+}
+
+void DatabaseClient::slot_addItemToListModelSorted(QString title, QString subtitle, quint32 itemId, int itemType, int itemLevel, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_addItemToListModelSorted(title, subtitle, itemId, itemType, itemLevel, modelId);
+    }
+}
+
+void DatabaseClient::slot_appendItemsToListModel(QList<KdbItem> items, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_appendItemsToListModel(items, modelId);
+    }
+}
+
+void DatabaseClient::slot_addItemsToListModelSorted(QList<KdbItem> items, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_addItemsToListModelSorted(items, modelId);
+    }
+}
+
+void DatabaseClient::slot_listModelWindowLoaded(QList<KdbItem> firstPage, int numItems, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_listModelWindowLoaded(firstPage, numItems, modelId);
+    }
+}
+
+void DatabaseClient::slot_listModelPageLoaded(int firstRow, QList<KdbItem> items, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_listModelPageLoaded(firstRow, items, modelId);
+    }
+}
+
+void DatabaseClient::slot_itemInsertedInListModelWindow(int row, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_itemInsertedInListModelWindow(row, modelId);
+    }
+}
+
+void DatabaseClient::slot_itemRemovedFromListModelWindow(int row, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_itemRemovedFromListModelWindow(row, modelId);
+    }
+}
+
+void DatabaseClient::slot_itemChangedInListModelWindow(int row, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_itemChangedInListModelWindow(row, modelId);
+    }
+}
+
+void DatabaseClient::slot_updateItemInListModel(QString title, QString subTitle, quint32 itemId, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_updateItemInListModel(title, subTitle, itemId, modelId);
+    }
+}
+
+void DatabaseClient::slot_updateItemInListModelSorted(QString title, QString subTitle, quint32 itemId, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_updateItemInListModelSorted(title, subTitle, itemId, modelId);
+    }
+}
+
+void DatabaseClient::slot_deleteItemInListModel(quint32 itemId, QList<quint32> modelIds)
+{
+    for (int i = 0; i < modelIds.count(); i++) {
+        QList<KdbListModel*> listModels = m_listModels.values(modelIds[i]);
+        for (int j = 0; j < listModels.count(); j++) {
+            listModels[j]->slot_deleteItem(itemId);
+        }
+    }
+}
+
+void DatabaseClient::slot_deleteItemsInListModel(QList<quint32> itemIds, quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_deleteItems(itemIds, modelId);
+    }
+}
+
+void DatabaseClient::slot_clearListModel(quint32 modelId)
+{
+    QList<KdbListModel*> listModels = m_listModels.values(modelId);
+    for (int i = 0; i < listModels.count(); i++) {
+        listModels[i]->slot_clearListModel(modelId);
+    }
+}
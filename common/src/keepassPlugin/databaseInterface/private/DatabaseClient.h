@@ -25,8 +25,10 @@
 
 #include <QObject>
 #include <QThread>
+#include <QMultiHash>
 #include "AbstractDatabaseInterface.h"
 #include "AbstractDatabaseFactory.h"
+#include "../KdbListModel.h"
 
 
 namespace kpxPrivate {
@@ -57,7 +59,33 @@ public:
         }
     }
 
+    // list models subscribe here for the items of their modelId, so that the items are
+    // only delivered to them and not to every list model
+    void subscribeListModel(quint32 modelId, kpxPublic::KdbListModel* listModel);
+    void unsubscribeListModel(kpxPublic::KdbListModel* listModel);
+
+private slots:
+    void slot_flushPendingChanges();
+
+    // signals from database interface which are routed to the subscribed list models
+    void slot_appendItemToListModel(QString title, QString subtitle, quint32 itemId, int itemType, int itemLevel, quint32 modelId);
+    void slot_addItemToListModelSorted(QString title, QString subtitle, quint32 itemId, int itemType, int itemLevel, quint32 modelId);
+    void slot_appendItemsToListModel(QList<kpxPublic::KdbItem> items, quint32 modelId);
+    void slot_addItemsToListModelSorted(QList<kpxPublic::KdbItem> items, quint32 modelId);
+    void slot_listModelWindowLoaded(QList<kpxPublic::KdbItem> firstPage, int numItems, quint32 modelId);
+    void slot_listModelPageLoaded(int firstRow, QList<kpxPublic::KdbItem> items, quint32 modelId);
+    void slot_itemInsertedInListModelWindow(int row, quint32 modelId);
+    void slot_itemRemovedFromListModelWindow(int row, quint32 modelId);
+    void slot_itemChangedInListModelWindow(int row, quint32 modelId);
+    void slot_updateItemInListModel(QString title, QString subTitle, quint32 itemId, quint32 modelId);
+    void slot_updateItemInListModelSorted(QString title, QString subTitle, quint32 itemId, quint32 modelId);
+    void slot_deleteItemInListModel(quint32 itemId, QList<quint32> modelIds);
+    void slot_deleteItemsInListModel(QList<quint32> itemIds, quint32 modelId);
+    void slot_clearListModel(quint32 modelId);
+
 private:
+    void connectListModelSignals();
+
     // prevent object creation, it will be created as singleton object
     DatabaseClient(QObject* parent = 0);
     Q_DISABLE_COPY(DatabaseClient)
@@ -70,6 +98,10 @@ private:
 
     // indicator for an initialized and ready to use database interface
     bool m_initialized;
+
+    // subscribed list models by modelId and the modelId of each list model
+    QMultiHash<quint32, kpxPublic::KdbListModel*> m_listModels;
+    QHash<kpxPublic::KdbListModel*, quint32> m_listModelIds;
 };
 
 }
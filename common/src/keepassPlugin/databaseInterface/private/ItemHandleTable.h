@@ -0,0 +1,135 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+#ifndef ITEMHANDLETABLE_H
+#define ITEMHANDLETABLE_H
+
+#include <QHash>
+#include <QVector>
+
+namespace kpxPrivate {
+
+/*!
+ * \brief The ItemHandleTable class gives groups and entries of a database a
+ * compact 32 bit handle, which is used as item ID in the list models and in
+ * the KdbEntry and KdbGroup objects.
+ *
+ * The lower 24 bits of a handle hold the slot in the table plus one and the
+ * next 7 bits a generation counter of that slot. The generation is increased
+ * when an item is removed, so that a handle of a deleted item does not refer
+ * to another item which gets the same slot later on. A slot whose generation
+ * is used up is retired instead of starting again at 0. The highest bit is never
+ * set, so a handle fits into an int property in QML, and a valid handle is
+ * never 0, so handles do not collide with the special list model IDs 0 (root
+ * group), 0xfffffffe (search) and 0xffffffff (dialogs).
+ *
+ * T is the key of an item in the database, e.g. the pointer to the group
+ * or entry object. It needs a qHash() function. Items must be removed from
+ * the table when they get deleted in the database.
+ */
+template <class T>
+class ItemHandleTable
+{
+public:
+    /*!
+     * \brief Returns the handle of an item and adds it to the table if it is
+     * not yet in there. A default constructed item (e.g. the NULL pointer of
+     * the root group) always gets the handle 0.
+     */
+    quint32 insert(const T& item, int itemType)
+    {
+        if (item == T()) return 0;
+        typename QHash<T, quint32>::const_iterator it = m_handles.constFind(item);
+        if (it != m_handles.constEnd()) return it.value();
+
+        int slot;
+        if (!m_freeSlots.isEmpty()) {
+            slot = m_freeSlots.last();
+            m_freeSlots.pop_back();
+        } else {
+            slot = m_slots.size();
+            Q_ASSERT(slot < int(INDEX_MASK));
+            m_slots.append(Slot());
+        }
+        m_slots[slot].item = item;
+        m_slots[slot].itemType = itemType;
+        quint32 handle = (m_slots[slot].generation << INDEX_BITS) | quint32(slot + 1);
+        m_handles.insert(item, handle);
+        return handle;
+    }
+
+    /*!
+     * \brief Returns the item for a handle or a default constructed item if
+     * the handle is not valid (anymore) or belongs to an item of another type.
+     */
+    T value(quint32 handle, int itemType) const
+    {
+        int slot = int(handle & INDEX_MASK) - 1;
+        if (slot < 0 || slot >= m_slots.size()) return T();
+        const Slot& s = m_slots[slot];
+        if (s.generation != (handle >> INDEX_BITS) || s.itemType != itemType) return T();
+        return s.item;
+    }
+
+    //! Removes an item from the table, its handle gets invalid.
+    void remove(const T& item)
+    {
+        quint32 handle = m_handles.take(item);
+        if (handle == 0) return;
+        int slot = int(handle & INDEX_MASK) - 1;
+        m_slots[slot].item = T();
+        m_slots[slot].itemType = 0;
+        // a retired slot gets a generation which no handle can have and is not used again
+        m_slots[slot].generation++;
+        if (m_slots[slot].generation <= GENERATION_MASK) {
+            m_freeSlots.append(slot);
+        }
+    }
+
+    void clear()
+    {
+        m_slots.clear();
+        m_freeSlots.clear();
+        m_handles.clear();
+    }
+
+private:
+    static const int INDEX_BITS = 24;
+    static const quint32 INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static const quint32 GENERATION_MASK = 0x7f;
+
+    struct Slot
+    {
+        Slot() : item(), itemType(0), generation(0) {}
+        T item;
+        int itemType;
+        quint32 generation;
+    };
+
+    QVector<Slot> m_slots;
+    QVector<int> m_freeSlots;
+    QHash<T, quint32> m_handles;
+};
+
+}
+
+#endif // ITEMHANDLETABLE_H
@@ -24,6 +24,8 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QDebug>
+#include <QTimer>
+#include <QtAlgorithms>
 
 #include "ownKeepassGlobal.h"
 #include "Keepass1DatabaseInterface.h"
@@ -52,7 +54,11 @@ Keepass1DatabaseInterface::Keepass1DatabaseInterface(QObject *parent)
       m_kdb3Database(NULL),
       m_setting_showUserNamePasswordsInListView(false),
       m_setting_sortAlphabeticallyInListView(true),
-      m_rootGroupId(0)
+      m_rootGroupId(0),
+      m_saveTimer(new QTimer(this)),
+      m_savePending(false),
+      m_searchIndexBuilt(false),
+      m_searchGeneration(0)
 {
     initDatabase();
 }
@@ -60,6 +66,12 @@ Keepass1DatabaseInterface::Keepass1DatabaseInterface(QObject *parent)
 Keepass1DatabaseInterface::~Keepass1DatabaseInterface()
 {
     qDebug("Destructor Keepass1DatabaseInterface");
+    // Pending changes are normally written by slot_flushPendingChanges() before the worker thread is stopped,
+    // this only catches changes if that did not happen. The save timer belongs to that thread and is not touched.
+    if (m_kdb3Database && m_savePending) {
+        m_savePending = false;
+        m_kdb3Database->save();
+    }
     delete m_kdb3Database;
     delete config;
     SecString::deleteSessionKey();
@@ -69,9 +81,89 @@ void Keepass1DatabaseInterface::initDatabase()
 {
     initYarrow();
     SecString::generateSessionKey();
+    // start key transformation threads now, so that this is not done while unlocking the database
+    KeyTransform::prepare();
 
     // init config
     config = new KpxConfig("keepassx-config.ini");
+
+    // changes arriving within a short time are written to the database file with one save
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SAVE_COALESCING_TIME);
+    bool ret = connect(m_saveTimer, SIGNAL(timeout()),
+                       this, SLOT(slot_savePendingChanges()));
+    Q_ASSERT(ret);
+}
+
+/*!
+\brief Saves the changes on the database after SAVE_COALESCING_TIME
+
+Changes arriving in the meantime are written with the same save. The result
+only tells if the database can be saved at all. Errors of the save itself
+are reported later with errorOccured() and RE_DB_SAVE_ERROR.
+
+\return false if the database is read only
+*/
+bool Keepass1DatabaseInterface::scheduleSave()
+{
+    Q_ASSERT(m_kdb3Database);
+    // report read only databases right away, the save itself would fail anyway
+    if (m_kdb3Database->isReadOnly()) {
+        return false;
+    }
+    m_savePending = true;
+    m_saveTimer->start();
+    return true;
+}
+
+bool Keepass1DatabaseInterface::saveDatabase()
+{
+    Q_ASSERT(m_kdb3Database);
+    // a full save includes all pending changes
+    m_saveTimer->stop();
+    m_savePending = false;
+    if (!m_kdb3Database->save()) {
+        return false;
+    }
+    sendDatabaseStages("save");
+    return true;
+}
+
+void Keepass1DatabaseInterface::sendDatabaseStages(const QString& operation)
+{
+    if (!m_stageTimer.isEnabled()) return;
+    // the stages of loading and saving are measured within the database library
+    m_stageTimer.start(operation);
+    const QList<Kdb3Database::Stage>& stages = m_kdb3Database->stages();
+    for (int i = 0; i < stages.count(); i++) {
+        m_stageTimer.addStage(stages[i].Name, stages[i].NSecs, stages[i].Bytes);
+    }
+    emit stagesTimed(operation, m_stageTimer.takeStages());
+}
+
+void Keepass1DatabaseInterface::slot_setting_stageTiming(bool value)
+{
+    m_stageTimer.setEnabled(value);
+    if (m_kdb3Database) {
+        m_kdb3Database->setStageTiming(value);
+    }
+}
+
+void Keepass1DatabaseInterface::flushPendingSave()
+{
+    if (m_kdb3Database && m_savePending) {
+        slot_savePendingChanges();
+    }
+}
+
+void Keepass1DatabaseInterface::slot_savePendingChanges()
+{
+    if (!m_kdb3Database || !m_savePending) return;
+
+    if (!saveDatabase()) {
+        emit errorOccured(DatabaseAccessResult::RE_DB_SAVE_ERROR, m_kdb3Database->getError());
+        qDebug("ERROR: %s", CSTR(m_kdb3Database->getError()));
+    }
 }
 
 #define OPEN_DB_CLEANUP \
@@ -97,6 +189,7 @@ void Keepass1DatabaseInterface::slot_openDatabase(QString filePath, QString pass
 
     // check if there is an already opened database and close it
     if (m_kdb3Database) {
+        flushPendingSave();
         if (!m_kdb3Database->close()) {
             // send signal with error
             emit errorOccured(DatabaseAccessResult::RE_DB_CLOSE_FAILED, m_kdb3Database->getError());
@@ -109,6 +202,13 @@ void Keepass1DatabaseInterface::slot_openDatabase(QString filePath, QString pass
 
     // create database object
     m_kdb3Database = new Kdb3Database();
+    m_kdb3Database->setStageTiming(m_stageTimer.isEnabled());
+    m_itemHandles.clear();
+    m_listModelItems.clear();
+    m_searchIndex.clear();
+    m_searchIndexBuilt = false;
+    m_searchSession = SearchSession();
+    m_searchJob = SearchJob();
 
     // set master password and key file to decrypt database
     if (!m_kdb3Database->setKey(password, keyfile)) {
@@ -140,6 +240,9 @@ void Keepass1DatabaseInterface::slot_openDatabase(QString filePath, QString pass
 
     // database was opened successfully
     emit databaseOpened(DatabaseAccessResult::RE_OK, "");
+    sendDatabaseStages("open");
+    // index the entries for searching when the requests which are already queued are done
+    QTimer::singleShot(0, this, SLOT(slot_buildSearchIndex()));
 
     // load used encryption and KeyTransfRounds and sent to KdbDatabase object so that it is shown in UI database settings page
     emit databaseCryptAlgorithmChanged(m_kdb3Database->cryptAlgorithm());
@@ -153,6 +256,8 @@ void Keepass1DatabaseInterface::slot_closeDatabase()
         emit errorOccured(DatabaseAccessResult::RE_DB_ALREADY_CLOSED, "");
         return;
     }
+    // write changes which are not saved yet
+    flushPendingSave();
     // close database
     if (!m_kdb3Database->close()) {
         emit errorOccured(DatabaseAccessResult::RE_DB_CLOSE_FAILED, m_kdb3Database->getError());
@@ -163,6 +268,10 @@ void Keepass1DatabaseInterface::slot_closeDatabase()
     }
     delete m_kdb3Database;
     m_kdb3Database = NULL;
+    m_searchIndex.clear();
+    m_searchIndexBuilt = false;
+    m_searchSession = SearchSession();
+    m_searchJob = SearchJob();
 
 // TODO delete .lock file
 
@@ -178,6 +287,7 @@ void Keepass1DatabaseInterface::slot_createNewDatabase(QString filePath, QString
 //    qDebug() << "Keepass1DatabaseInterface::slot_createNewDatabase() - dbPath: " << filePath << " pw: " << password << " keyfile: " << keyfile;
     // check if there is an already opened database and close it
     if (m_kdb3Database) {
+        flushPendingSave();
         if (!m_kdb3Database->close()) {
             // send signal with error
             emit errorOccured(DatabaseAccessResult::RE_DB_CLOSE_FAILED, m_kdb3Database->getError());
@@ -192,6 +302,13 @@ void Keepass1DatabaseInterface::slot_createNewDatabase(QString filePath, QString
 
     // create database object
     m_kdb3Database = new Kdb3Database();
+    m_kdb3Database->setStageTiming(m_stageTimer.isEnabled());
+    m_itemHandles.clear();
+    m_listModelItems.clear();
+    m_searchIndex.clear();
+    m_searchIndexBuilt = false;
+    m_searchSession = SearchSession();
+    m_searchJob = SearchJob();
 
     m_kdb3Database->create();
     if (!m_kdb3Database->changeFile(filePath)) {
@@ -203,6 +320,10 @@ void Keepass1DatabaseInterface::slot_createNewDatabase(QString filePath, QString
         return;
     }
     m_kdb3Database->setCryptAlgorithm(CryptAlgorithm(cryptAlgorithm));
+    // negative value means calibrate the rounds for the given open time in milliseconds
+    if (keyTransfRounds < 0) {
+        keyTransfRounds = KeyTransformBenchmark::benchmark(-keyTransfRounds);
+    }
     m_kdb3Database->setKeyTransfRounds(keyTransfRounds);
     if (!m_kdb3Database->setKey(password, keyfile)) {
         // send signal with error
@@ -233,6 +354,8 @@ void Keepass1DatabaseInterface::slot_createNewDatabase(QString filePath, QString
 
 // TODO create .lock file
 
+    // the rounds might have been calibrated above, so the UI gets the actual value
+    emit databaseKeyTransfRoundsChanged(m_kdb3Database->keyTransfRounds());
     // send signal with success code
     emit newDatabaseCreated();
 }
@@ -247,7 +370,7 @@ void Keepass1DatabaseInterface::slot_changePassKey(QString password, QString key
     }
     m_kdb3Database->generateMasterKey();
     // save database
-    if (!m_kdb3Database->save()) {
+    if (!saveDatabase()) {
         // send signal with error
         emit errorOccured(DatabaseAccessResult::RE_DB_SAVE_ERROR, m_kdb3Database->getError());
         return;
@@ -264,6 +387,13 @@ void Keepass1DatabaseInterface::slot_loadMasterGroups(bool registerListModel)
     } else {
         masterGroups = m_kdb3Database->groups();
     }
+    quint32 listModelId = 0xffffffff;
+    if (registerListModel) {
+        // save modelId and master group only if needed
+        // i.e. save model list id for master group page and don't do it for list models used in dialogs
+        listModelId = 0;
+    }
+    QList<KdbItem> items;
     for (int i = 0; i < masterGroups.count(); i++) {
         IGroupHandle* masterGroup = masterGroups.at(i);
 //        qDebug() << "int of mastergroup: " << uint(masterGroup);
@@ -274,60 +404,55 @@ void Keepass1DatabaseInterface::slot_loadMasterGroups(bool registerListModel)
             int item_level = masterGroup->level();
             if (masterGroup->title() != "Backup") {
                 int numberOfSubgroups = masterGroup->children().count();
-                int numberOfEntries = m_kdb3Database->entries(masterGroup).count();
-                int listModelId = 0xffffffff;
+                int numberOfEntries = masterGroup->numEntries();
                 if (registerListModel) {
-                    // save modelId and master group only if needed
-                    // i.e. save model list id for master group page and don't do it for list models used in dialogs
-                    listModelId = 0;
-                    m_groups_modelId.insertMulti(listModelId, uint(masterGroup));
+                    m_listModelItems.registerItem(listModelId, itemHandle(masterGroup));
                 }
-                emit appendItemToListModel(masterGroup->title(),                           // group name
-                                           QString("Subgroups: %1 | Entries: %2")
-                                           .arg(numberOfSubgroups).arg(numberOfEntries),   // subtitle
-                                           uInt2QString(uint(masterGroup)),                  // item id
-                                           DatabaseItemType::GROUP,                        // item type
-                                           item_level,                                     // item level (0 = root, 1 = first level, etc.
-                                           uInt2QString(uint(listModelId)));                 // list model of root group
+                items << KdbItem(masterGroup->title(),                           // group name
+                                 QString("Subgroups: %1 | Entries: %2")
+                                 .arg(numberOfSubgroups).arg(numberOfEntries),   // subtitle
+                                 itemHandle(masterGroup),                        // item id
+                                 DatabaseItemType::GROUP,                        // item type
+                                 item_level);                                    // item level (0 = root, 1 = first level, etc.
             }
         }
     }
+    // send all groups to the list model of the root group at once
+    if (!items.isEmpty()) {
+        emit appendItemsToListModel(items, listModelId);
+    }
     emit masterGroupsLoaded(DatabaseAccessResult::RE_OK);
 }
 
-void Keepass1DatabaseInterface::slot_loadGroupsAndEntries(QString groupId)
+void Keepass1DatabaseInterface::slot_loadGroupsAndEntries(quint32 groupId)
 {
 //    qDebug() << "groupId " << groupId;
 
     Q_ASSERT(m_kdb3Database);
     // load sub groups and entries
-    IGroupHandle* group = (IGroupHandle*)qString2UInt(groupId);
-    Q_ASSERT(group);
+    IGroupHandle* group = groupFromId(groupId);
+    if (!group) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
 //    qDebug() << "int of group: " << uint(group);
 
+    // only the direct subgroups of the group are looked at, the sorted order is cached per group
     QList<IGroupHandle*> subGroups;
     if (m_setting_sortAlphabeticallyInListView) {
-        subGroups = m_kdb3Database->sortedGroups();
+        subGroups = m_kdb3Database->sortedChildren(group);
     } else {
-        subGroups = m_kdb3Database->groups();
+        subGroups = group->children();
     }
+    QList<IGroupHandle*> groups;
     for (int i = 0; i < subGroups.count(); i++) {
         IGroupHandle* subGroup = subGroups.at(i);
-//        qDebug() << "int of subgroup: " << uint(subGroup->parent()) << " (title: " << subGroup->parent()->title() << ")";
 
-        if (subGroup->isValid() && subGroup->parent() == group) {
+        if (subGroup->isValid()) {
 //            qDebug("Group %d: %s", i, CSTR(subGroup->title()));
-            int numberOfSubgroups = subGroup->children().count();
-            int numberOfEntries = m_kdb3Database->entries(subGroup).count();
-            emit appendItemToListModel(subGroup->title(),                              // group name
-                                       QString("Subgroups: %1 | Entries: %2")
-                                       .arg(numberOfSubgroups).arg(numberOfEntries),   // subtitle
-                                       uInt2QString(uint(subGroup)),                     // item id
-                                       DatabaseItemType::GROUP,                        // item type
-                                       0,                                              // item level (not used here)
-                                       groupId);                                       // list model gets groupId as its unique ID
+            groups << subGroup;
             // save modelId and group
-            m_groups_modelId.insertMulti(uint(group), uint(subGroup));
+            m_listModelItems.registerItem(itemHandle(group), itemHandle(subGroup));
         }
     }
 
@@ -337,28 +462,30 @@ void Keepass1DatabaseInterface::slot_loadGroupsAndEntries(QString groupId)
     } else {
         entries = m_kdb3Database->entries(group);
     }
+    QList<IEntryHandle*> validEntries;
     for (int i = 0; i < entries.count(); i++) {
         IEntryHandle* entry = entries.at(i);
         if (entry->isValid()) {
-            emit appendItemToListModel(entry->title(),                                 // group name
-                                       getUserAndPassword(entry),                      // subtitle
-                                       uInt2QString(uint(entry)),                        // item id
-                                       DatabaseItemType::ENTRY,                        // item type
-                                       0,                                              // item level (not used here)
-                                       groupId);                                       // list model gets groupId as its unique ID
+            validEntries << entry;
             // save modelId and entry
-            m_entries_modelId.insertMulti(uint(group), uint(entry));
+            m_listModelItems.registerItem(itemHandle(group), itemHandle(entry));
         }
     }
+    // list model gets groupId as its unique ID
+    sendItemsToListModel(groups, validEntries, false, groupId);
     emit groupsAndEntriesLoaded(DatabaseAccessResult::RE_OK);
 }
 
-void Keepass1DatabaseInterface::slot_loadEntry(QString entryId)
+void Keepass1DatabaseInterface::slot_loadEntry(quint32 entryId)
 {
 //    qDebug() << "entryId " << entryId;
 
     // get entry handler for entryId
-    IEntryHandle* entry = (IEntryHandle*)qString2UInt(entryId);
+    IEntryHandle* entry = entryFromId(entryId);
+    if (!entry) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(entryId, 16));
+        return;
+    }
     // decrypt password which is usually stored encrypted in memory
     SecString password = entry->password();
     password.unlock();
@@ -389,80 +516,105 @@ void Keepass1DatabaseInterface::slot_loadEntry(QString entryId)
     password.lock();
 }
 
-void Keepass1DatabaseInterface::slot_loadGroup(QString groupId)
+void Keepass1DatabaseInterface::slot_loadGroup(quint32 groupId)
 {
 //    qDebug() << "groupId " << groupId;
 
     // get group handler for groupId
-    IGroupHandle* group = (IGroupHandle*)qString2UInt(groupId);
-    Q_ASSERT(group);
+    IGroupHandle* group = groupFromId(groupId);
+    if (!group) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
     emit groupLoaded(DatabaseAccessResult::RE_OK, groupId, group->title());
 }
 
-void Keepass1DatabaseInterface::slot_saveGroup(QString groupId, QString title)
+void Keepass1DatabaseInterface::slot_saveGroup(quint32 groupId, QString title)
 {
 //    qDebug() << "groupId " << groupId;
 
     Q_ASSERT(m_kdb3Database);
 
     //  save changes on group details to database
-    IGroupHandle* group = (IGroupHandle*)qString2UInt(groupId);
-    Q_ASSERT(group); // Master group (0) cannot be changed
+    IGroupHandle* group = groupFromId(groupId);
+    // Master group (0) cannot be changed
+    if (!group) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
     group->setTitle(title);
-    if (!m_kdb3Database->save()) {
+    if (!scheduleSave()) {
         emit groupSaved(DatabaseAccessResult::RE_DB_SAVE_ERROR, groupId);
         return;
     }
 
     // update all list models which contain the changed group
-    QList<int> modelIds = m_groups_modelId.keys(uint(group));
+    QList<quint32> modelIds = m_listModelItems.models(itemHandle(group));
     int numberOfSubgroups = group->children().count();
-    int numberOfEntries = m_kdb3Database->entries(group).count();
+    int numberOfEntries = group->numEntries();
     for (int i = 0; i < modelIds.count(); i++) {
         if (m_setting_sortAlphabeticallyInListView) {
             emit updateItemInListModelSorted(title,                                           // update group name
                                              QString("Subgroups: %1 | Entries: %2")
                                              .arg(numberOfSubgroups).arg(numberOfEntries),    // subtitle
                                              groupId,                                         // identifier for group item in list model
-                                             uInt2QString(modelIds[i]));                       // identifier for list model
+                                             modelIds[i]);                                     // identifier for list model
         } else {
             emit updateItemInListModel(title,                                           // update group name
                                        QString("Subgroups: %1 | Entries: %2")
                                        .arg(numberOfSubgroups).arg(numberOfEntries),    // subtitle
                                        groupId,                                         // identifier for group item in list model
-                                       uInt2QString(modelIds[i]));                       // identifier for list model
+                                       modelIds[i]);                                     // identifier for list model
         }
+        updateItemInListModelWindow(groupId, DatabaseItemType::GROUP, title, modelIds[i]);
     }
     // signal to QML
     emit groupSaved(DatabaseAccessResult::RE_OK, groupId);
 }
 
-void Keepass1DatabaseInterface::slot_unregisterListModel(QString modelId)
+void Keepass1DatabaseInterface::slot_unregisterListModel(quint32 modelId)
 {
 //    qDebug() << "modelId " << modelId;
 
     // delete all groups and entries which are associated with given modelId
-    m_groups_modelId.remove(qString2UInt(modelId));
-    m_entries_modelId.remove(qString2UInt(modelId));
+    m_listModelItems.unregisterModel(modelId);
+    m_listModelWindows.remove(modelId);
+    if (modelId == 0xfffffffe) {
+        // the search list model is gone, a running search is not needed anymore
+        m_searchSession.valid = false;
+        m_searchJob.running = false;
+    }
 }
 
-void Keepass1DatabaseInterface::slot_createNewGroup(QString title, quint32 iconId, QString parentGroupId)
+void Keepass1DatabaseInterface::slot_loadListModelPage(quint32 modelId, int firstRow, int count)
+{
+    // list model might have been unregistered or reloaded in the meantime
+    if (!m_listModelWindows.contains(modelId)) return;
+    emit listModelPageLoaded(firstRow, listModelPage(m_listModelWindows[modelId], firstRow, count), modelId);
+}
+
+void Keepass1DatabaseInterface::slot_createNewGroup(QString title, quint32 iconId, quint32 parentGroupId)
 {
 //    qDebug() << "parentGroupId " << parentGroupId;
 
     Q_ASSERT(m_kdb3Database);
 
     // get parent group handle and identify IDs of list model
-    IGroupHandle* parentGroup = (IGroupHandle*)qString2UInt(parentGroupId);
+    IGroupHandle* parentGroup = groupFromId(parentGroupId);
+    // parent group is NULL for the root group (0)
+    if (!parentGroup && parentGroupId != 0) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(parentGroupId, 16));
+        return;
+    }
 
     CGroup* groupData = new CGroup(); // ownership will be given to m_kdb3Database object
     groupData->Title = title;
     groupData->Image = iconId;
     IGroupHandle* newGroup = m_kdb3Database->addGroup(groupData, parentGroup);
     Q_ASSERT(newGroup);
-    // save changes to database
-    if (!m_kdb3Database->save()) {
-        emit newGroupCreated(DatabaseAccessResult::RE_DB_SAVE_ERROR, uInt2QString(uint(newGroup)));
+    // schedule saving changes to database
+    if (!scheduleSave()) {
+        emit newGroupCreated(DatabaseAccessResult::RE_DB_SAVE_ERROR, itemHandle(newGroup));
         return;
     }
 
@@ -470,20 +622,21 @@ void Keepass1DatabaseInterface::slot_createNewGroup(QString title, quint32 iconI
     if (m_setting_sortAlphabeticallyInListView) {
         emit addItemToListModelSorted(title,                                       // group name
                                       "Subgroups: 0 | Entries: 0",                 // subtitle
-                                      uInt2QString(uint(newGroup)),                  // item id
+                                      itemHandle(newGroup),                          // item id
                                       DatabaseItemType::GROUP,                     // item type
                                       0,                                           // item level (not used here)
                                       parentGroupId);                              // for distinguishing different models
     } else {
         emit appendItemToListModel(title,                                          // group name
                                    "Subgroups: 0 | Entries: 0",                    // subtitle
-                                   uInt2QString(uint(newGroup)),                     // item id
+                                   itemHandle(newGroup),                             // item id
                                    DatabaseItemType::GROUP,                        // item type
                                    0,                                              // item level (not used here)
                                    parentGroupId);                                 // for distinguishing different models
     }
+    insertItemInListModelWindow(itemHandle(newGroup), DatabaseItemType::GROUP, title, parentGroupId);
     // save modelid and group
-    m_groups_modelId.insertMulti(uint(parentGroup), uint(newGroup));
+    m_listModelItems.registerItem(itemHandle(parentGroup), itemHandle(newGroup));
 
     // update all grandparent groups subtitle in UI
     // check if parent group is root group, then we don't need to do anything
@@ -492,10 +645,10 @@ void Keepass1DatabaseInterface::slot_createNewGroup(QString title, quint32 iconI
     }
 
     // signal to QML
-    emit newGroupCreated(DatabaseAccessResult::RE_OK, uInt2QString(uint(newGroup)));
+    emit newGroupCreated(DatabaseAccessResult::RE_OK, itemHandle(newGroup));
 }
 
-void Keepass1DatabaseInterface::slot_saveEntry(QString entryId,
+void Keepass1DatabaseInterface::slot_saveEntry(quint32 entryId,
                                                QString title,
                                                QString url,
                                                QString username,
@@ -506,8 +659,11 @@ void Keepass1DatabaseInterface::slot_saveEntry(QString entryId,
 
     Q_ASSERT(m_kdb3Database);
     //  save changes on entry details to database
-    IEntryHandle* entry = (IEntryHandle*)qString2UInt(entryId);
-    Q_ASSERT(entry);
+    IEntryHandle* entry = entryFromId(entryId);
+    if (!entry) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(entryId, 16));
+        return;
+    }
 
     entry->setTitle(title);
     entry->setUrl(url);
@@ -517,26 +673,28 @@ void Keepass1DatabaseInterface::slot_saveEntry(QString entryId,
     s_password.lock();
     entry->setPassword(s_password);
     entry->setComment(comment);
-    // save changes to database and send signal with result
-    if (!m_kdb3Database->save()) {
+    updateSearchIndex(entry);
+    // schedule saving changes to database and send signal with result
+    if (!scheduleSave()) {
         emit entrySaved(DatabaseAccessResult::RE_DB_SAVE_ERROR, entryId);
         return;
     }
 
     // update entry item in list model
-    QList<int> modelIds = m_entries_modelId.keys(uint(entry));
+    QList<quint32> modelIds = m_listModelItems.models(itemHandle(entry));
     for (int i = 0; i < modelIds.count(); i++) {
         if (m_setting_sortAlphabeticallyInListView) {
             emit updateItemInListModelSorted(title,                                 // group name
                                              getUserAndPassword(entry),             // subtitle
                                              entryId,                               // identifier for item in list model
-                                             uInt2QString(modelIds[i]));             // identifier for list model of master group
+                                             modelIds[i]);                           // identifier for list model of master group
         } else {
             emit updateItemInListModel(title,                                       // group name
                                        getUserAndPassword(entry),                   // subtitle
                                        entryId,                                     // identifier for item in list model
-                                       uInt2QString(modelIds[i]));                   // identifier for list model of master group
+                                       modelIds[i]);                                 // identifier for list model of master group
         }
+        updateItemInListModelWindow(entryId, DatabaseItemType::ENTRY, title, modelIds[i]);
     }
     // signal to QML
     emit entrySaved(DatabaseAccessResult::RE_OK, entryId);
@@ -574,13 +732,16 @@ void Keepass1DatabaseInterface::slot_createNewEntry(QString title,
                                              QString username,
                                              QString password,
                                              QString comment,
-                                             QString parentGroupId)
+                                             quint32 parentGroupId)
 {
 //    qDebug() << "parentGroupId " << parentGroupId;
 
     // create new entry in specified group
-    IGroupHandle* parentGroup = (IGroupHandle*)qString2UInt(parentGroupId);
-    Q_ASSERT(parentGroup);
+    IGroupHandle* parentGroup = groupFromId(parentGroupId);
+    if (!parentGroup) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(parentGroupId, 16));
+        return;
+    }
     Q_ASSERT(m_kdb3Database);
     IEntryHandle* newEntry = m_kdb3Database->newEntry(parentGroup);
     // add data to new entry
@@ -592,9 +753,10 @@ void Keepass1DatabaseInterface::slot_createNewEntry(QString title,
     s_password.lock();
     newEntry->setPassword(s_password);
     newEntry->setComment(comment);
-    // save changes to database
-    if (!m_kdb3Database->save()) {
-        emit newEntryCreated(DatabaseAccessResult::RE_DB_SAVE_ERROR, uInt2QString(uint(newEntry)));
+    updateSearchIndex(newEntry);
+    // schedule saving changes to database
+    if (!scheduleSave()) {
+        emit newEntryCreated(DatabaseAccessResult::RE_DB_SAVE_ERROR, itemHandle(newEntry));
         return;
     }
 
@@ -602,46 +764,58 @@ void Keepass1DatabaseInterface::slot_createNewEntry(QString title,
     if (m_setting_sortAlphabeticallyInListView) {
         emit addItemToListModelSorted(title,                                       // title
                                       getUserAndPassword(newEntry),                // subtitle
-                                      uInt2QString(uint(newEntry)),                  // item id
+                                      itemHandle(newEntry),                          // item id
                                       DatabaseItemType::ENTRY,                     // item type
                                       0,                                           // item level (not used here)
                                       parentGroupId);                              // id of list model where to put this entry in
     } else {
         emit appendItemToListModel(title,                                          // title
                                    getUserAndPassword(newEntry),                   // subtitle
-                                   uInt2QString(uint(newEntry)),                     // item id
+                                   itemHandle(newEntry),                             // item id
                                    DatabaseItemType::ENTRY,                        // item type
                                    0,                                              // item level (not used here)
                                    parentGroupId);                                 // id of list model where to put this entry in
     }
+    insertItemInListModelWindow(itemHandle(newEntry), DatabaseItemType::ENTRY, title, parentGroupId);
     // save modelId and entry
-    m_entries_modelId.insertMulti(uint(parentGroup), uint(newEntry));
+    m_listModelItems.registerItem(itemHandle(parentGroup), itemHandle(newEntry));
 
     // update all grandparent groups subtitle, ie. entries counter has to be updated in UI
     updateGrandParentGroupInListModel(parentGroup);
     // signal to QML
-    emit newEntryCreated(DatabaseAccessResult::RE_OK, uInt2QString(uint(newEntry)));
+    emit newEntryCreated(DatabaseAccessResult::RE_OK, itemHandle(newEntry));
 }
 
-void Keepass1DatabaseInterface::slot_deleteGroup(QString groupId)
+void Keepass1DatabaseInterface::slot_deleteGroup(quint32 groupId)
 {
 //    qDebug() << "groupId " << groupId;
 
     // get group handles
-    IGroupHandle* group = (IGroupHandle*)qString2UInt(groupId);
-    Q_ASSERT(group);
+    IGroupHandle* group = groupFromId(groupId);
+    if (!group) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
     IGroupHandle* parentGroup = group->parent();
+    // drop the group with all its subgroups and entries from list models which are filled page by page,
+    // their handles are not valid anymore after deleting the group
+    removeGroupFromListModelWindows(group);
+    // list models which show the group, needed after its handle is released
+    QList<quint32> modelIds = m_listModelItems.models(groupId);
+    // IDs of the deleted items must not refer to new items which get the same memory later on
+    releaseItemHandles(group);
+    invalidateSearchResult();
     // delete group from database
     Q_ASSERT(m_kdb3Database);
     m_kdb3Database->deleteGroup(group);
-    // save changes to database
-    if (!m_kdb3Database->save()) {
+    // schedule saving changes to database
+    if (!scheduleSave()) {
         emit groupDeleted(DatabaseAccessResult::RE_DB_SAVE_ERROR, groupId);
         return;
     }
 
-    // remove group from all active list models where it might be added
-    emit deleteItemInListModel(groupId);
+    // remove group from the list models where it was added
+    emit deleteItemInListModel(groupId, modelIds);
 
     // update all grandparent groups subtitle, ie. subgroup counter has to be updated in UI
     if (parentGroup != NULL) { // if parent group is root group we don't need to do anything
@@ -656,71 +830,305 @@ void Keepass1DatabaseInterface::updateGrandParentGroupInListModel(IGroupHandle*
     Q_ASSERT(m_kdb3Database);
     IGroupHandle* grandParentGroup = parentGroup->parent();
     int numberOfSubgroups = parentGroup->children().count();
-    int numberOfEntries = m_kdb3Database->entries(parentGroup).count();
+    int numberOfEntries = parentGroup->numEntries();
     emit updateItemInListModel(parentGroup->title(),                                // group name
                                QString("Subgroups: %1 | Entries: %2")
                                .arg(numberOfSubgroups).arg(numberOfEntries),        // subtitle
-                               uInt2QString(uint(parentGroup)),                       // identifier for group item in list model
-                               uInt2QString(uint(grandParentGroup)));                 // identifier for list model
+                               itemHandle(parentGroup),                               // identifier for group item in list model
+                               itemHandle(grandParentGroup));                         // identifier for list model
+    // position of the group does not change here, only its subtitle
+    quint32 modelId = itemHandle(grandParentGroup);
+    if (m_listModelWindows.contains(modelId)) {
+        int row = m_listModelWindows[modelId].itemIds.indexOf(itemHandle(parentGroup));
+        if (row >= 0) {
+            emit itemChangedInListModelWindow(row, modelId);
+        }
+    }
+}
+
+KdbItem Keepass1DatabaseInterface::groupItem(IGroupHandle* group, int itemLevel)
+{
+    return KdbItem(group->title(),                                  // group name
+                   QString("Subgroups: %1 | Entries: %2")
+                   .arg(group->children().count())
+                   .arg(group->numEntries()),                       // subtitle
+                   itemHandle(group),                               // item id
+                   DatabaseItemType::GROUP,                         // item type
+                   itemLevel);                                      // item level
+}
+
+KdbItem Keepass1DatabaseInterface::entryItem(IEntryHandle* entry)
+{
+    return KdbItem(entry->title(),                                  // entry name
+                   getUserAndPassword(entry),                       // subtitle
+                   itemHandle(entry),                               // item id
+                   DatabaseItemType::ENTRY,                         // item type
+                   0);                                              // item level (not used here)
+}
+
+/*!
+\brief Send groups and entries to a list model
+
+Small lists are sent to the list model at once. If there are more than
+LIST_MODEL_WINDOW_THRESHOLD items only their ids are kept in a
+ListModelWindow and the list model gets the first page of items. The other
+pages are created on request in slot_loadListModelPage(), so that titles and
+subtitles are only prepared for the part of the list which is shown.
+
+\param sortEntries Entries are not sorted yet and need to be sorted alphabetically
+*/
+void Keepass1DatabaseInterface::sendItemsToListModel(const QList<IGroupHandle*>& groups,
+                                                     const QList<IEntryHandle*>& entries,
+                                                     bool sortEntries,
+                                                     quint32 modelId)
+{
+    m_listModelWindows.remove(modelId);
+    int numItems = groups.count() + entries.count();
+    if (numItems == 0) return;
+
+    if (numItems <= LIST_MODEL_WINDOW_THRESHOLD) {
+        QList<KdbItem> items;
+        for (int i = 0; i < groups.count(); i++) {
+            items << groupItem(groups.at(i), 0);
+        }
+        for (int i = 0; i < entries.count(); i++) {
+            items << entryItem(entries.at(i));
+        }
+        if (sortEntries) {
+            emit addItemsToListModelSorted(items, modelId);
+        } else {
+            emit appendItemsToListModel(items, modelId);
+        }
+        return;
+    }
+
+    ListModelWindow window;
+    for (int i = 0; i < groups.count(); i++) {
+        window.itemIds << itemHandle(groups.at(i));
+    }
+    window.numGroups = groups.count();
+    if (sortEntries) {
+        QList<ListModelSortKey> keys;
+        for (int i = 0; i < entries.count(); i++) {
+            ListModelSortKey key;
+            key.title = KdbItem::sortKey(entries.at(i)->title());
+            key.itemId = itemHandle(entries.at(i));
+            keys << key;
+        }
+        qStableSort(keys);
+        for (int i = 0; i < keys.count(); i++) {
+            window.itemIds << keys[i].itemId;
+        }
+    } else {
+        for (int i = 0; i < entries.count(); i++) {
+            window.itemIds << itemHandle(entries.at(i));
+        }
+    }
+    m_listModelWindows.insert(modelId, window);
+    emit listModelWindowLoaded(listModelPage(window, 0, LIST_MODEL_PAGE_SIZE), numItems, modelId);
+}
+
+QList<KdbItem> Keepass1DatabaseInterface::listModelPage(const ListModelWindow& window, int firstRow, int count)
+{
+    QList<KdbItem> items;
+    int end = qMin(firstRow + count, window.itemIds.count());
+    for (int row = qMax(firstRow, 0); row < end; row++) {
+        if (row < window.numGroups) {
+            IGroupHandle* group = groupFromId(window.itemIds[row]);
+            items << (group ? groupItem(group, 0) : KdbItem());
+        } else {
+            IEntryHandle* entry = entryFromId(window.itemIds[row]);
+            items << (entry ? entryItem(entry) : KdbItem());
+        }
+    }
+    return items;
+}
+
+QString Keepass1DatabaseInterface::listModelWindowTitle(const ListModelWindow& window, int row)
+{
+    // the item might have been deleted in the meantime
+    if (row < window.numGroups) {
+        IGroupHandle* group = groupFromId(window.itemIds[row]);
+        return group ? group->title() : QString();
+    } else {
+        IEntryHandle* entry = entryFromId(window.itemIds[row]);
+        return entry ? entry->title() : QString();
+    }
+}
+
+void Keepass1DatabaseInterface::insertItemInListModelWindow(quint32 itemId, int itemType, const QString& title, quint32 modelId)
+{
+    if (!m_listModelWindows.contains(modelId)) return;
+    ListModelWindow& window = m_listModelWindows[modelId];
+    // groups are put at the beginning of the list before entries
+    int row = 0;
+    int max = 0;
+    if (itemType == DatabaseItemType::ENTRY) {
+        row = window.numGroups;
+        max = window.itemIds.count();
+    } else {
+        max = window.numGroups;
+        ++window.numGroups;
+    }
+    if (m_setting_sortAlphabeticallyInListView) {
+        // binary search in the sorted part of the list
+        QString key = KdbItem::sortKey(title);
+        while (row < max) {
+            int middle = row + (max - row) / 2;
+            if (KdbItem::sortKey(listModelWindowTitle(window, middle)) < key) {
+                row = middle + 1;
+            } else {
+                max = middle;
+            }
+        }
+    } else {
+        row = max;
+    }
+    window.itemIds.insert(row, itemId);
+    emit itemInsertedInListModelWindow(row, modelId);
+}
+
+void Keepass1DatabaseInterface::updateItemInListModelWindow(quint32 itemId, int itemType, const QString& title, quint32 modelId)
+{
+    if (!m_listModelWindows.contains(modelId)) return;
+    ListModelWindow& window = m_listModelWindows[modelId];
+    int row = window.itemIds.indexOf(itemId);
+    if (row < 0) return;
+    if (m_setting_sortAlphabeticallyInListView) {
+        // a new title might change the position of the item
+        window.itemIds.removeAt(row);
+        if (row < window.numGroups) {
+            --window.numGroups;
+        }
+        emit itemRemovedFromListModelWindow(row, modelId);
+        insertItemInListModelWindow(itemId, itemType, title, modelId);
+    } else {
+        emit itemChangedInListModelWindow(row, modelId);
+    }
+}
+
+void Keepass1DatabaseInterface::removeItemFromListModelWindows(quint32 itemId)
+{
+    QHash<quint32, ListModelWindow>::iterator it;
+    for (it = m_listModelWindows.begin(); it != m_listModelWindows.end(); ++it) {
+        int row = it.value().itemIds.indexOf(itemId);
+        if (row >= 0) {
+            it.value().itemIds.removeAt(row);
+            if (row < it.value().numGroups) {
+                --it.value().numGroups;
+            }
+            emit itemRemovedFromListModelWindow(row, it.key());
+        }
+    }
+}
+
+void Keepass1DatabaseInterface::removeGroupFromListModelWindows(IGroupHandle* group)
+{
+    if (m_listModelWindows.isEmpty()) return;
+    QList<IGroupHandle*> children = group->children();
+    for (int i = 0; i < children.count(); i++) {
+        removeGroupFromListModelWindows(children.at(i));
+    }
+    QList<IEntryHandle*> entries = m_kdb3Database->entries(group);
+    for (int i = 0; i < entries.count(); i++) {
+        removeItemFromListModelWindows(itemHandle(entries.at(i)));
+    }
+    removeItemFromListModelWindows(itemHandle(group));
 }
 
-void Keepass1DatabaseInterface::slot_deleteEntry(QString entryId)
+void Keepass1DatabaseInterface::releaseItemHandles(IGroupHandle* group)
+{
+    QList<IGroupHandle*> children = group->children();
+    for (int i = 0; i < children.count(); i++) {
+        releaseItemHandles(children.at(i));
+    }
+    QList<IEntryHandle*> entries = m_kdb3Database->entries(group);
+    for (int i = 0; i < entries.count(); i++) {
+        m_listModelItems.unregisterItem(itemHandle(entries.at(i)));
+        m_searchIndex.remove(itemHandle(entries.at(i)));
+        m_itemHandles.remove(entries.at(i));
+    }
+    m_listModelItems.unregisterItem(itemHandle(group));
+    m_itemHandles.remove(group);
+}
+
+void Keepass1DatabaseInterface::slot_deleteEntry(quint32 entryId)
 {
 //    qDebug() << "entryId " << entryId;
 
     // get handles
-    IEntryHandle* entry = (IEntryHandle*)qString2UInt(entryId);
-    Q_ASSERT(entry);
+    IEntryHandle* entry = entryFromId(entryId);
+    if (!entry) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(entryId, 16));
+        return;
+    }
     IGroupHandle* parentGroup = entry->group();
     Q_ASSERT(parentGroup);
 
     Q_ASSERT(m_kdb3Database);
     // delete entry from database
     m_kdb3Database->deleteEntry(entry);
-    // save changes to database
-    if (!m_kdb3Database->save()) {
+    // list models which show the entry, needed after its handle is released
+    QList<quint32> modelIds = m_listModelItems.models(entryId);
+    m_listModelItems.unregisterItem(itemHandle(entry));
+    m_searchIndex.remove(itemHandle(entry));
+    invalidateSearchResult();
+    m_itemHandles.remove(entry);
+    // schedule saving changes to database
+    if (!scheduleSave()) {
         emit entryDeleted(DatabaseAccessResult::RE_DB_SAVE_ERROR, entryId);
         return;
     }
 
-    // remove entry from all active list models where it might be added
-    emit deleteItemInListModel(entryId);
+    // remove entry from the list models where it was added
+    emit deleteItemInListModel(entryId, modelIds);
+    removeItemFromListModelWindows(entryId);
     // update all grandparent groups subtitle, ie. entries counter has to be updated in UI
     updateGrandParentGroupInListModel(parentGroup);
     // signal to QML
     emit entryDeleted(DatabaseAccessResult::RE_OK, entryId);
 }
 
-void Keepass1DatabaseInterface::slot_moveEntry(QString entryId, QString newGroupId)
+void Keepass1DatabaseInterface::slot_moveEntry(quint32 entryId, quint32 newGroupId)
 {
 //    qDebug() << "entryId " << entryId;
 //    qDebug() << "newGroupId " << newGroupId;
 
-    IEntryHandle* entry = (IEntryHandle*)qString2UInt(entryId);
-    Q_ASSERT(entry);
+    IEntryHandle* entry = entryFromId(entryId);
+    if (!entry) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(entryId, 16));
+        return;
+    }
     IGroupHandle* parentGroup = entry->group();
     Q_ASSERT(parentGroup);
-    IGroupHandle* newGroup = (IGroupHandle*)qString2UInt(newGroupId);
-    Q_ASSERT(newGroup);
+    IGroupHandle* newGroup = groupFromId(newGroupId);
+    if (!newGroup) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(newGroupId, 16));
+        return;
+    }
     Q_ASSERT(m_kdb3Database);
 
     // move entry to new group within the database
     m_kdb3Database->moveEntry(entry, newGroup);
-    // save changes to database
-    if (!m_kdb3Database->save()) {
+    // the entry might have left or entered the group of the last search
+    invalidateSearchResult();
+    // schedule saving changes to database
+    if (!scheduleSave()) {
         emit entryMoved(DatabaseAccessResult::RE_DB_SAVE_ERROR, entryId);
         return;
     }
 
-    // remove entry from all active list models where it might be added
-    emit deleteItemInListModel(entryId);
+    // remove entry from the list models where it was added
+    emit deleteItemInListModel(entryId, m_listModelItems.models(entryId));
+    removeItemFromListModelWindows(entryId);
+    m_listModelItems.unregisterItem(itemHandle(entry));
     // update all grandparent groups subtitle, ie. entries counter has to be updated in UI
     updateGrandParentGroupInListModel(parentGroup);
 
     // add entry item in list model of new group if this group is actually visible in UI
-    if (m_groups_modelId.contains(uint(newGroup))) {
+    if (m_listModelItems.containsModel(itemHandle(newGroup))) {
         // register entry to list model of parent group
-        m_entries_modelId.insertMulti(uint(newGroup), uint(entry));
+        m_listModelItems.registerItem(itemHandle(newGroup), itemHandle(entry));
         // now update list model with moved entry
         if (m_setting_sortAlphabeticallyInListView) {
             emit addItemToListModelSorted(entry->title(),                          // entry name
@@ -738,6 +1146,10 @@ void Keepass1DatabaseInterface::slot_moveEntry(QString entryId, QString newGroup
                                        newGroupId);                                // identifier for list model where this item should be inserted
         }
     }
+    if (m_listModelWindows.contains(newGroupId)) {
+        m_listModelItems.registerItem(itemHandle(newGroup), itemHandle(entry));
+        insertItemInListModelWindow(entryId, DatabaseItemType::ENTRY, entry->title(), newGroupId);
+    }
     // update subtitle of parent list model where password entry was moved to
     parentGroup = entry->group();
     updateGrandParentGroupInListModel(parentGroup);
@@ -745,54 +1157,205 @@ void Keepass1DatabaseInterface::slot_moveEntry(QString entryId, QString newGroup
     emit entryMoved(DatabaseAccessResult::RE_OK, entryId);
 }
 
-void Keepass1DatabaseInterface::slot_moveGroup(QString groupId, QString newParentGroupId)
+void Keepass1DatabaseInterface::slot_moveGroup(quint32 groupId, quint32 newParentGroupId)
 {
     Q_UNUSED(groupId);
     Q_UNUSED(newParentGroupId);
     // TODO
 }
 
-void Keepass1DatabaseInterface::slot_searchEntries(QString searchString, QString rootGroupId)
+void Keepass1DatabaseInterface::slot_searchEntries(QString searchString, quint32 rootGroupId)
 {
 //    qDebug() << "rootGroupId " << rootGroupId;
 
-    // get group handle
-    IGroupHandle* rootGroup = (IGroupHandle*)qString2UInt(rootGroupId);
-    // search for entries in database
-    // rootGroup is the groups from which search is performed recursively in the (sub-)tree of the database
+    // replace a running search, the new one starts when the requests which are already queued are done,
+    // so that of the search requests which are queued while typing only the last one is performed
+    m_searchJob = SearchJob();
+    m_searchJob.generation = ++m_searchGeneration;
+    m_searchJob.running = true;
+    m_searchJob.searchString = searchString;
+    m_searchJob.rootGroupId = rootGroupId;
+    QMetaObject::invokeMethod(this, "slot_continueSearch", Qt::QueuedConnection, Q_ARG(uint, m_searchJob.generation));
+}
+
+void Keepass1DatabaseInterface::slot_continueSearch(uint generation)
+{
+    // chunks of a replaced search are dropped
+    if (generation != m_searchJob.generation || !m_searchJob.running) return;
     Q_ASSERT(m_kdb3Database);
-    QList<IEntryHandle*> entries = m_kdb3Database->search(rootGroup,    // root group
-                                                          searchString, // search string
-                                                          false,        // is case sensitive
-                                                          false,        // is regular expression
-                                                          true,         // recursive search
-                                                          NULL);        // fields to search
-    // update list model with found entries
-    for (int i = 0; i < entries.count(); i++) {
-        IEntryHandle* entry = entries.at(i);
-        if (entry->isValid()) {
-//            qDebug() << "entry found: " << entry->title() << " " << uint(entry);
-            if (m_setting_sortAlphabeticallyInListView) {
-                emit addItemToListModelSorted(entry->title(),                              // entry name
-                                              getUserAndPassword(entry),                   // subtitle
-                                              uInt2QString(uint(entry)),                     // item id
-                                              DatabaseItemType::ENTRY,                     // item type
-                                              0,                                           // item level (not used here)
-                                              uInt2QString(0xfffffffe));                            // specifying model where entry should be added (search list model gets 0xfffffffe)
-            } else {
-                emit appendItemToListModel(entry->title(),                                 // entry name
-                                           getUserAndPassword(entry),                      // subtitle
-                                           uInt2QString(uint(entry)),                        // item id
-                                           DatabaseItemType::ENTRY,                        // item type
-                                           0,                                              // item level (not used here)
-                                           uInt2QString(0xfffffffe));                               // specifying model where entry should be added (search list model gets 0xfffffffe)
+
+    // get group handle, the group might have been deleted between the chunks
+    // rootGroup is the groups from which search is performed recursively in the (sub-)tree of the database
+    IGroupHandle* rootGroup = groupFromId(m_searchJob.rootGroupId);
+    if (!rootGroup && m_searchJob.rootGroupId != 0) {
+        m_searchJob.running = false;
+        emit searchEntriesCompleted(DatabaseAccessResult::RE_ERR_SEARCH);
+        return;
+    }
+    quint32 searchId = 0xfffffffe;
+    if (!m_searchJob.started) {
+        m_stageTimer.start("search");
+        // Keepass 1 matches the search string as a whole
+        m_searchJob.words = QStringList(m_searchJob.searchString);
+        if (refineSearch(m_searchJob.searchString, m_searchJob.rootGroupId, m_searchJob.words)) {
+            m_searchJob.running = false;
+            m_stageTimer.endStage("refine");
+            emit searchEntriesCompleted(DatabaseAccessResult::RE_OK);
+            if (m_stageTimer.isEnabled()) {
+                emit stagesTimed(m_stageTimer.operation(), m_stageTimer.takeStages());
             }
+            return;
+        }
+        slot_buildSearchIndex();
+        m_searchJob.candidates = m_searchIndex.candidates(m_searchJob.words);
+        m_searchJob.started = true;
+        // results of a previous search are replaced
+        m_searchSession.valid = false;
+        m_listModelItems.unregisterModel(0xfffffffe);
+        m_listModelWindows.remove(searchId);
+        emit clearListModel(searchId);
+    }
+
+    // check the next chunk of entries
+    QList<quint32> found = m_searchIndex.filter(m_searchJob.candidates.mid(m_searchJob.position, SEARCH_CHUNK_SIZE),
+                                                m_searchJob.words);
+    m_searchJob.position += SEARCH_CHUNK_SIZE;
+    IGroupHandle* backupGroup = m_kdb3Database->backupGroup();
+    QList<IEntryHandle*> foundEntries;
+    for (int i = 0; i < found.count(); i++) {
+        IEntryHandle* entry = (IEntryHandle*)m_itemHandles.value(found[i], DatabaseItemType::ENTRY);
+        if (entry && entry->isValid() && isInSearchScope(entry, rootGroup, backupGroup)) {
+            foundEntries << entry;
             // save modelId and entry
-            m_entries_modelId.insertMulti(0xfffffffe, uint(entry));
+            m_listModelItems.registerItem(0xfffffffe, found[i]);
+            m_searchJob.itemIds << found[i];
         }
     }
+    // found entries are shown right away unless there are so many that the list model gets them page by page
+    if (!foundEntries.isEmpty() && m_searchJob.itemIds.count() <= LIST_MODEL_WINDOW_THRESHOLD) {
+        QList<KdbItem> items;
+        for (int i = 0; i < foundEntries.count(); i++) {
+            items << entryItem(foundEntries.at(i));
+        }
+        if (m_setting_sortAlphabeticallyInListView) {
+            emit addItemsToListModelSorted(items, searchId);
+        } else {
+            emit appendItemsToListModel(items, searchId);
+        }
+    }
+    if (m_searchJob.position < m_searchJob.candidates.count()) {
+        // let other requests in before the next chunk
+        QMetaObject::invokeMethod(this, "slot_continueSearch", Qt::QueuedConnection, Q_ARG(uint, generation));
+        return;
+    }
+
+    // search is finished
+    m_searchJob.running = false;
+    m_stageTimer.endStage("search");
+    if (m_searchJob.itemIds.count() > LIST_MODEL_WINDOW_THRESHOLD) {
+        QList<IEntryHandle*> entries;
+        for (int i = 0; i < m_searchJob.itemIds.count(); i++) {
+            IEntryHandle* entry = (IEntryHandle*)m_itemHandles.value(m_searchJob.itemIds[i], DatabaseItemType::ENTRY);
+            if (entry) {
+                entries << entry;
+            }
+        }
+        // specifying model where entries should be added (search list model gets 0xfffffffe)
+        sendItemsToListModel(QList<IGroupHandle*>(), entries, m_setting_sortAlphabeticallyInListView, searchId);
+        m_stageTimer.endStage("send results");
+    }
+    m_searchSession.valid = !m_searchJob.databaseChanged;
+    m_searchSession.searchString = m_searchJob.searchString;
+    m_searchSession.rootGroupId = m_searchJob.rootGroupId;
+    m_searchSession.itemIds = m_searchJob.itemIds;
     // signal to QML
     emit searchEntriesCompleted(DatabaseAccessResult::RE_OK);
+    if (m_stageTimer.isEnabled()) {
+        emit stagesTimed(m_stageTimer.operation(), m_stageTimer.takeStages());
+    }
+}
+
+bool Keepass1DatabaseInterface::refineSearch(const QString& searchString, quint32 rootGroupId, const QStringList& words)
+{
+    if (!m_searchSession.isRefinedBy(searchString, rootGroupId)) return false;
+    slot_buildSearchIndex();
+    // the new search string contains the last one, so only entries of the last result can still match
+    QList<quint32> found = m_searchIndex.filter(m_searchSession.itemIds, words);
+    QSet<quint32> removedIds;
+    for (int i = 0, j = 0; i < m_searchSession.itemIds.count(); i++) {
+        // filter() keeps the order, so the entries which are gone are found in one pass
+        quint32 entryHandle = m_searchSession.itemIds[i];
+        if (j < found.count() && found[j] == entryHandle) {
+            ++j;
+            continue;
+        }
+        removedIds.insert(entryHandle);
+        m_listModelItems.unregisterItem(0xfffffffe, entryHandle);
+    }
+    m_searchSession.searchString = searchString;
+    m_searchSession.itemIds = found;
+    if (removedIds.isEmpty()) return true;
+
+    quint32 searchModelId = 0xfffffffe;
+    if (m_listModelWindows.contains(searchModelId)) {
+        // go backwards so that the rows which are still to be checked do not change
+        ListModelWindow& window = m_listModelWindows[searchModelId];
+        for (int row = window.itemIds.count() - 1; row >= 0; row--) {
+            if (removedIds.contains(window.itemIds[row])) {
+                window.itemIds.removeAt(row);
+                emit itemRemovedFromListModelWindow(row, searchModelId);
+            }
+        }
+    } else {
+        emit deleteItemsInListModel(removedIds.toList(), searchModelId);
+    }
+    return true;
+}
+
+void Keepass1DatabaseInterface::slot_buildSearchIndex()
+{
+    if (!m_kdb3Database || m_searchIndexBuilt) return;
+    QList<IEntryHandle*> entries = m_kdb3Database->entries();
+    for (int i = 0; i < entries.count(); i++) {
+        m_searchIndex.insert(itemHandle(entries.at(i)), searchIndexFields(entries.at(i)));
+    }
+    m_searchIndexBuilt = true;
+}
+
+QStringList Keepass1DatabaseInterface::searchIndexFields(IEntryHandle* entry)
+{
+    // title, username, url, comment and attachment description are searched, the password is never indexed
+    QStringList fields;
+    fields << entry->title() << entry->username() << entry->url() << entry->comment() << entry->binaryDesc();
+    return fields;
+}
+
+void Keepass1DatabaseInterface::updateSearchIndex(IEntryHandle* entry)
+{
+    // until the index is built the entry will be added together with all others
+    if (m_searchIndexBuilt) {
+        m_searchIndex.insert(itemHandle(entry), searchIndexFields(entry));
+    }
+    // the changed entry might match the next search string although it was not in the last result
+    invalidateSearchResult();
+}
+
+bool Keepass1DatabaseInterface::isInSearchScope(IEntryHandle* entry, IGroupHandle* rootGroup, IGroupHandle* backupGroup)
+{
+    // skip entries from the backup group and from outside of the searched group
+    IGroupHandle* group = entry->group();
+    bool inRootGroup = (rootGroup == NULL || group == rootGroup);
+    while (group->parent()) {
+        group = group->parent();
+        inRootGroup = inRootGroup || group == rootGroup;
+    }
+    return inRootGroup && group != backupGroup;
+}
+
+void Keepass1DatabaseInterface::invalidateSearchResult()
+{
+    m_searchSession.valid = false;
+    m_searchJob.databaseChanged = true;
 }
 
 inline QString Keepass1DatabaseInterface::getUserAndPassword(IEntryHandle* entry)
@@ -815,17 +1378,32 @@ void Keepass1DatabaseInterface::slot_changeKeyTransfRounds(int value)
     // do nothing if no database is opened database
     if (!m_kdb3Database) return;
 
+    // negative value means calibrate the rounds for the given open time in milliseconds
+    if (value < 0) {
+        value = KeyTransformBenchmark::benchmark(-value);
+    }
     // set key transformation rounds in database and emit changed signal
     m_kdb3Database->setKeyTransfRounds(value);
     m_kdb3Database->generateMasterKey();
     emit databaseKeyTransfRoundsChanged(m_kdb3Database->keyTransfRounds());
     // save changes to database
-    if (!m_kdb3Database->save()) {
+    if (!saveDatabase()) {
         emit errorOccured(DatabaseAccessResult::RE_DB_SAVE_ERROR, "");
         return;
     }
 }
 
+void Keepass1DatabaseInterface::slot_calibrateKeyTransfRounds(int targetTime)
+{
+    // measure key transformation speed of this device, also done if opening the database failed
+    int rounds = KeyTransformBenchmark::benchmark(targetTime);
+    int openTime = -1;
+    if (m_kdb3Database) {
+        openTime = KeyTransformBenchmark::transformTime(m_kdb3Database->keyTransfRounds());
+    }
+    emit keyTransfRoundsCalibrated(rounds, openTime);
+}
+
 void Keepass1DatabaseInterface::slot_changeCryptAlgorithm(int value)
 {
     // do nothing if no database is opened database
@@ -835,59 +1413,46 @@ void Keepass1DatabaseInterface::slot_changeCryptAlgorithm(int value)
     m_kdb3Database->setCryptAlgorithm(CryptAlgorithm(value));
     emit databaseCryptAlgorithmChanged(m_kdb3Database->cryptAlgorithm());
     // save changes to database
-    if (!m_kdb3Database->save()) {
+    if (!saveDatabase()) {
         emit errorOccured(DatabaseAccessResult::RE_DB_SAVE_ERROR, "");
         return;
     }
 }
 
 /*!
-\brief Convert integer number to QString
+\brief Get the handle of a group or entry
 
-The integer number is converted into a 4 byte long hexadecimal QString.
+The handle is used as compact ID of the item in the list models and in QML
+instead of the memory address of the item. The root group (NULL) has the
+handle 0.
+*/
+quint32 Keepass1DatabaseInterface::itemHandle(IGroupHandle* group)
+{
+    return m_itemHandles.insert(group, DatabaseItemType::GROUP);
+}
 
-\param value This is the integer value which shall be converted to QString
+quint32 Keepass1DatabaseInterface::itemHandle(IEntryHandle* entry)
+{
+    return m_itemHandles.insert(entry, DatabaseItemType::ENTRY);
+}
 
-\return Hexadecimal QString representation of the integer number
+/*!
+\brief Get the group for an ID which was handed out by itemHandle()
+
+\return NULL if the ID is the root group (0) or if the group does not exist anymore
 */
-inline QString Keepass1DatabaseInterface::uInt2QString(uint value)
+IGroupHandle* Keepass1DatabaseInterface::groupFromId(quint32 groupId)
 {
-    if (value == 0) {
-        return "0";
-    } else if (value == 0xfffffffe) {
-        return "fffffffe";
-    } else {
-        return QString(QByteArray::number(value, 16));
-    }
+    return (IGroupHandle*)m_itemHandles.value(groupId, DatabaseItemType::GROUP);
 }
 
 /*!
-\brief Convert QString to integer
-
-Convert a 4 byte long hexadecimal number in string format to a integer number.
-It emits errorOccured signal with result RE_ERR_QSTRING_TO_INT and QString value
-if conversion from QString to integer number fails.
+\brief Get the entry for an ID which was handed out by itemHandle()
 
-\param value This is the QString value which shall be converted to integer
-\return positive number if conversion succeeded
-        0xfffffffe placeholder for search group if database search is ongoing
-        0xffffffff if conversion did not succeed
+\return NULL if the entry does not exist anymore
 */
-inline uint Keepass1DatabaseInterface::qString2UInt(QString value)
+IEntryHandle* Keepass1DatabaseInterface::entryFromId(quint32 entryId)
 {
-    bool ok = false;
-    // threat QString value as hexadecimal number
-    uint uintValue = value.toLatin1().toUInt(&ok, 16);
-    if (ok) {
-        return uintValue;
-    } else {
-        if (value.compare("0")) {
-            return 0;
-        } else if (value.compare("fffffffe")) {
-            return 0xfffffffe;
-        } else {
-            emit errorOccured(DatabaseAccessResult::RE_ERR_QSTRING_TO_INT, value);
-            return 0xffffffff;
-        }
-    }
+    return (IEntryHandle*)m_itemHandles.value(entryId, DatabaseItemType::ENTRY);
 }
+
@@ -24,7 +24,12 @@
 #define KEEPASS1DATABASEINTERFACE_H
 
 #include <QObject>
+#include <QTimer>
 #include "AbstractDatabaseInterface.h"
+#include "ItemHandleTable.h"
+#include "ListModelRegistry.h"
+#include "SearchIndex.h"
+#include "StageTimer.h"
 #include "../KdbDatabase.h"
 #include "../KdbListModel.h"
 #include "database/Kdb3Database.h"
@@ -53,61 +58,83 @@ signals:
     void passwordChanged();
     void databaseKeyTransfRoundsChanged(int value);
     void databaseCryptAlgorithmChanged(int value);
+    void keyTransfRoundsCalibrated(int rounds, int openTime);
+    void stagesTimed(QString operation, QVariantList stages);
     void errorOccured(int result,
                       QString errorMsg);
 
     // signals to KdbListModel object
     void appendItemToListModel(QString title,
                                QString subtitle,
-                               QString itemId,
+                               quint32 itemId,
                                int itemType,
                                int itemLevel,
-                               QString modelId);
+                               quint32 modelId);
     void addItemToListModelSorted(QString title,
                                   QString subtitle,
-                                  QString itemId,
+                                  quint32 itemId,
                                   int itemType,
                                   int itemLevel,
-                                  QString modelId);
+                                  quint32 modelId);
+    void appendItemsToListModel(QList<kpxPublic::KdbItem> items,
+                                quint32 modelId);
+    void addItemsToListModelSorted(QList<kpxPublic::KdbItem> items,
+                                   quint32 modelId);
+    void listModelWindowLoaded(QList<kpxPublic::KdbItem> firstPage,
+                               int numItems,
+                               quint32 modelId);
+    void listModelPageLoaded(int firstRow,
+                             QList<kpxPublic::KdbItem> items,
+                             quint32 modelId);
+    void itemInsertedInListModelWindow(int row,
+                                       quint32 modelId);
+    void itemRemovedFromListModelWindow(int row,
+                                        quint32 modelId);
+    void itemChangedInListModelWindow(int row,
+                                      quint32 modelId);
     void updateItemInListModel(QString title,
                                QString subTitle,
-                               QString itemId,
-                               QString modelId);
+                               quint32 itemId,
+                               quint32 modelId);
     void updateItemInListModelSorted(QString title,
                                      QString subTitle,
-                                     QString itemId,
-                                     QString modelId);
+                                     quint32 itemId,
+                                     quint32 modelId);
     void masterGroupsLoaded(int result);
     void groupsAndEntriesLoaded(int result);
-    void deleteItemInListModel(QString itemId);
+    void deleteItemInListModel(quint32 itemId,
+                               QList<quint32> modelIds);
+    void deleteItemsInListModel(QList<quint32> itemIds,
+                                quint32 modelId);
+    void clearListModel(quint32 modelId);
     void searchEntriesCompleted(int result);
 
     // signal to KdbEntry object
     void entryLoaded(int result,
-                     QString entryId,
+                     quint32 entryId,
                      QList<QString> keys,
                      QList<QString> values);
     void entrySaved(int result,
-                    QString entryId);
+                    quint32 entryId);
     void newEntryCreated(int result,
-                         QString entryId);
+                         quint32 entryId);
     void entryDeleted(int result,
-                      QString entryId);
+                      quint32 entryId);
     void entryMoved(int result,
-                    QString entryId);
+                    quint32 entryId);
 
     // signal to KdbGroup object
     void groupLoaded(int result,
-                     QString groupId,
+                     quint32 groupId,
                      QString title);
     void groupSaved(int result,
-                    QString groupId);
+                    quint32 groupId);
     void newGroupCreated(int result,
-                         QString groupId);
+                         quint32 groupId);
     void groupDeleted(int result,
-                      QString groupId);
+                      quint32 groupId);
     void groupMoved(int result,
-                    QString groupId);
+                    quint32 groupId);
 
 public slots:
     // signals from KdbDatabase object
@@ -121,23 +148,29 @@ public slots:
                                 int cryptAlgorithm,
                                 int keyTransfRounds);
     void slot_closeDatabase();
+    void slot_flushPendingChanges() { flushPendingSave(); }
     void slot_changePassKey(QString password,
                             QString keyFile);
     void slot_changeKeyTransfRounds(int value);
+    void slot_calibrateKeyTransfRounds(int targetTime);
     void slot_changeCryptAlgorithm(int value);
     void slot_setting_showUserNamePasswordsInListView(bool value) { m_setting_showUserNamePasswordsInListView = value; }
     void slot_setting_sortAlphabeticallyInListView(bool value) { m_setting_sortAlphabeticallyInListView = value; }
+    void slot_setting_stageTiming(bool value);
 
     // signal from KdbListModel object
     void slot_loadMasterGroups(bool registerListModel);
-    void slot_loadGroupsAndEntries(QString groupId);
-    void slot_unregisterListModel(QString modelId);
+    void slot_loadGroupsAndEntries(quint32 groupId);
+    void slot_unregisterListModel(quint32 modelId);
+    void slot_loadListModelPage(quint32 modelId,
+                                int firstRow,
+                                int count);
     void slot_searchEntries(QString searchString,
-                            QString rootGroupId);
+                            quint32 rootGroupId);
 
     // signal from KdbEntry object
-    void slot_loadEntry(QString entryId);
-    void slot_saveEntry(QString entryId,
+    void slot_loadEntry(quint32 entryId);
+    void slot_saveEntry(quint32 entryId,
                         QString title,
                         QString url,
                         QString username,
@@ -148,28 +181,57 @@ public slots:
                              QString username,
                              QString password,
                              QString comment,
-                             QString parentGroupId);
-    void slot_deleteEntry(QString entryId);
-    void slot_moveEntry(QString entryId,
-                        QString newGroupId);
+                             quint32 parentGroupId);
+    void slot_deleteEntry(quint32 entryId);
+    void slot_moveEntry(quint32 entryId,
+                        quint32 newGroupId);
 
     // signal from KdbGroup object
-    void slot_loadGroup(QString groupId);
-    void slot_saveGroup(QString groupId,
+    void slot_loadGroup(quint32 groupId);
+    void slot_saveGroup(quint32 groupId,
                         QString title);
     void slot_createNewGroup(QString title,
                              quint32 iconId,
-                             QString parentGroupId);
-    void slot_deleteGroup(QString groupId);
-    void slot_moveGroup(QString groupId,
-                        QString newParentGroupId);
+                             quint32 parentGroupId);
+    void slot_deleteGroup(quint32 groupId);
+    void slot_moveGroup(quint32 groupId,
+                        quint32 newParentGroupId);
+
+private slots:
+    void slot_savePendingChanges();
+    void slot_buildSearchIndex();
+    void slot_continueSearch(uint generation);
 
 private:
     void initDatabase();
+    bool scheduleSave();
+    bool saveDatabase();
+    void flushPendingSave();
+    void sendDatabaseStages(const QString& operation);
     void updateGrandParentGroupInListModel(IGroupHandle* parentGroup);
+    KdbItem groupItem(IGroupHandle* group, int itemLevel);
+    KdbItem entryItem(IEntryHandle* entry);
+    void sendItemsToListModel(const QList<IGroupHandle*>& groups,
+                              const QList<IEntryHandle*>& entries,
+                              bool sortEntries,
+                              quint32 modelId);
+    QList<KdbItem> listModelPage(const ListModelWindow& window, int firstRow, int count);
+    QString listModelWindowTitle(const ListModelWindow& window, int row);
+    void insertItemInListModelWindow(quint32 itemId, int itemType, const QString& title, quint32 modelId);
+    void updateItemInListModelWindow(quint32 itemId, int itemType, const QString& title, quint32 modelId);
+    void removeItemFromListModelWindows(quint32 itemId);
+    void removeGroupFromListModelWindows(IGroupHandle* group);
+    void releaseItemHandles(IGroupHandle* group);
+    QStringList searchIndexFields(IEntryHandle* entry);
+    bool refineSearch(const QString& searchString, quint32 rootGroupId, const QStringList& words);
+    void updateSearchIndex(IEntryHandle* entry);
+    bool isInSearchScope(IEntryHandle* entry, IGroupHandle* rootGroup, IGroupHandle* backupGroup);
+    void invalidateSearchResult();
+    quint32 itemHandle(IGroupHandle* group);
+    quint32 itemHandle(IEntryHandle* entry);
+    IGroupHandle* groupFromId(quint32 groupId);
+    IEntryHandle* entryFromId(quint32 entryId);
     inline QString getUserAndPassword(IEntryHandle* entry);
-    inline QString uInt2QString(uint value);
-    inline uint qString2UInt(QString value);
 
 private:
     // Keepass database handler
@@ -178,11 +240,29 @@ private:
     // settings
     bool m_setting_showUserNamePasswordsInListView;
     bool m_setting_sortAlphabeticallyInListView;
+    // measures the stages of open, save and search if enabled
+    StageTimer m_stageTimer;
 
-    // The following two hash tables store information about which list models are showing a dedicated entry or group in the UI
-    QHash<int, int> m_entries_modelId;
-    QHash<int, int> m_groups_modelId;
+    // compact IDs of groups and entries which are handed out to the list models and QML
+    ItemHandleTable<void*> m_itemHandles;
+    // information about which list models are showing a dedicated entry or group in the UI
+    ListModelRegistry m_listModelItems;
     int m_rootGroupId;
+    // ordered items of list models which are filled page by page, key is the modelId
+    QHash<quint32, ListModelWindow> m_listModelWindows;
+    // index of the entries for searching, it is built after the database was opened
+    SearchIndex m_searchIndex;
+    bool m_searchIndexBuilt;
+    // result of the last search, used to refine it while the search string is extended
+    SearchSession m_searchSession;
+    // search which is running in chunks, see slot_searchEntries()
+    SearchJob m_searchJob;
+    uint m_searchGeneration;
+
+    // Changes on groups and entries are not saved immediately but collected for SAVE_COALESCING_TIME milliseconds,
+    // so that a burst of edits results in only one rewrite of the database file
+    QTimer* m_saveTimer;
+    bool m_savePending;
 };
 
 }
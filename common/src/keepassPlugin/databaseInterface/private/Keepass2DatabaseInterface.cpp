@@ -21,17 +21,26 @@
 ***************************************************************************/
 
 #include <QDebug>
+#include <QtAlgorithms>
+#include <QBuffer>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include "ownKeepassGlobal.h"
 #include "Keepass2DatabaseInterface.h"
 #include "../KdbListModel.h"
 #include "../KdbGroup.h"
 #include "crypto/Crypto.h"
+#include "format/KeePass2.h"
 #include "format/KeePass2Reader.h"
+#include "format/KeePass2Writer.h"
 #include "keys/PasswordKey.h"
 #include "keys/FileKey.h"
+#include "keys/CompositeKey.h"
 #include "core/Group.h"
-#include "core/EntrySearcher.h"
+#include "core/Entry.h"
+#include "core/Metadata.h"
+#include "core/Uuid.h"
 
 
 using namespace kpxPrivate;
@@ -41,9 +50,16 @@ using namespace ownKeepassPublic;
 Keepass2DatabaseInterface::Keepass2DatabaseInterface(QObject *parent)
     : QObject(parent),
       m_Database(NULL),
+      m_readOnly(true),
       m_setting_showUserNamePasswordsInListView(false),
       m_setting_sortAlphabeticallyInListView(true),
-      m_rootGroupId(0)
+      m_rootGroupId(0),
+      m_searchIndexBuilt(false),
+      m_searchGeneration(0),
+      m_saveTimer(new QTimer(this)),
+      m_savePending(false),
+      m_saveWatcher(new QFutureWatcher<QString>(this)),
+      m_saveSize(0)
 {
     initDatabase();
 }
@@ -51,6 +67,9 @@ Keepass2DatabaseInterface::Keepass2DatabaseInterface(QObject *parent)
 Keepass2DatabaseInterface::~Keepass2DatabaseInterface()
 {
     qDebug("Destructor Keepass2DatabaseInterface");
+    // Pending changes are normally written by slot_flushPendingChanges() before the worker thread is stopped.
+    // The save timer belongs to that thread, so it is not touched here.
+    writePendingSave();
     delete m_Database;
 }
 
@@ -63,6 +82,142 @@ void Keepass2DatabaseInterface::initDatabase()
         delete m_Database;
     }
 
+    // changes arriving within a short time are written to the database file with one save
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SAVE_COALESCING_TIME);
+    bool ret = connect(m_saveTimer, SIGNAL(timeout()),
+                       this, SLOT(slot_savePendingChanges()));
+    Q_ASSERT(ret);
+    ret = connect(m_saveWatcher, SIGNAL(finished()),
+                  this, SLOT(slot_databaseFileWritten()));
+    Q_ASSERT(ret);
+}
+
+/*!
+\brief Write the content of a database file
+
+The content is written to a temporary file first which replaces the database
+file only after all data reached the disk. So the database file is never left
+half written. This function runs in a thread of the global thread pool.
+
+\return Empty string on success, otherwise the error message
+*/
+static QString writeDatabaseFile(const QString& filePath, const QByteArray& data)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return file.errorString();
+    }
+    if (file.write(data) != data.size()) {
+        QString errorMsg = file.errorString();
+        file.cancelWriting();
+        return errorMsg;
+    }
+    if (!file.commit()) {
+        return file.errorString();
+    }
+    return QString();
+}
+
+/*!
+\brief Marks the database as changed and starts the save timer
+
+The file is written by slot_savePendingChanges() and writeDatabaseFile()
+after the timer expired, so a failing write cannot be returned here. It is
+signalled with errorOccured() and RE_DB_SAVE_ERROR instead.
+
+\return false if the database is read only
+*/
+bool Keepass2DatabaseInterface::scheduleSave()
+{
+    Q_ASSERT(m_Database);
+    // report read only databases right away, the save itself would fail anyway
+    if (m_readOnly) {
+        return false;
+    }
+    m_savePending = true;
+    m_saveTimer->start();
+    return true;
+}
+
+bool Keepass2DatabaseInterface::serializeDatabase(QByteArray& data)
+{
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    KeePass2Writer writer;
+    writer.writeDatabase(&buffer, m_Database);
+    if (writer.hasError()) {
+        emit errorOccured(DatabaseAccessResult::RE_DB_SAVE_ERROR, writer.errorString());
+        qDebug() << "ERROR: " << writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+void Keepass2DatabaseInterface::slot_savePendingChanges()
+{
+    if (!m_Database || !m_savePending) return;
+    // only one write at a time, changes done meanwhile are saved when it is finished
+    if (m_saveWatcher->isRunning()) return;
+
+    // The database objects belong to this thread, so the file content is created here. It is a snapshot
+    // of the database, later changes go into the next save.
+    m_saveStageTimer.start("save");
+    QByteArray data;
+    if (!serializeDatabase(data)) return;
+    m_savePending = false;
+    m_saveSize = data.size();
+    m_saveStageTimer.endStage("serialize and encrypt", m_saveSize);
+    m_saveWatcher->setFuture(QtConcurrent::run(writeDatabaseFile, m_filePath, data));
+}
+
+void Keepass2DatabaseInterface::slot_databaseFileWritten()
+{
+    QString errorMsg = m_saveWatcher->result();
+    if (!errorMsg.isEmpty()) {
+        // the changes are not in the file, so they are written again with the next save
+        m_savePending = true;
+        emit errorOccured(DatabaseAccessResult::RE_DB_SAVE_ERROR, errorMsg);
+        qDebug() << "ERROR: " << errorMsg;
+        return;
+    }
+    if (m_saveStageTimer.isEnabled()) {
+        m_saveStageTimer.endStage("write", m_saveSize);
+        emit stagesTimed(m_saveStageTimer.operation(), m_saveStageTimer.takeStages());
+    }
+    // save changes which were done while the file was written
+    if (m_savePending && !m_saveTimer->isActive()) {
+        slot_savePendingChanges();
+    }
+}
+
+void Keepass2DatabaseInterface::flushPendingSave()
+{
+    m_saveTimer->stop();
+    writePendingSave();
+}
+
+void Keepass2DatabaseInterface::writePendingSave()
+{
+    // the database file must be complete before the database is closed or another one is opened
+    m_saveWatcher->waitForFinished();
+    if (!m_Database || !m_savePending) return;
+
+    m_saveStageTimer.start("save");
+    QByteArray data;
+    if (!serializeDatabase(data)) return;
+    m_saveStageTimer.endStage("serialize and encrypt", data.size());
+    QString errorMsg = writeDatabaseFile(m_filePath, data);
+    if (!errorMsg.isEmpty()) {
+        emit errorOccured(DatabaseAccessResult::RE_DB_SAVE_ERROR, errorMsg);
+        qDebug() << "ERROR: " << errorMsg;
+        return;
+    }
+    m_savePending = false;
+    if (m_saveStageTimer.isEnabled()) {
+        m_saveStageTimer.endStage("write", data.size());
+        emit stagesTimed(m_saveStageTimer.operation(), m_saveStageTimer.takeStages());
+    }
 }
 
 void Keepass2DatabaseInterface::slot_openDatabase(QString filePath, QString password, QString keyfile, bool readonly)
@@ -93,23 +248,28 @@ void Keepass2DatabaseInterface::slot_openDatabase(QString filePath, QString pass
     }
 
     CompositeKey masterKey;
-    masterKey.addKey(PasswordKey(password));
-    if (!keyfile.isEmpty()) {
-        FileKey key;
-        QString errorMsg;
-        if (!key.load(keyfile, &errorMsg)) {
-            emit databaseOpened(DatabaseAccessResult::RE_KEYFILE_OPEN_ERROR, errorMsg);
-            return;
-        }
-        masterKey.addKey(key);
+    QString keyErrorMsg;
+    if (!buildMasterKey(password, keyfile, masterKey, keyErrorMsg)) {
+        emit databaseOpened(DatabaseAccessResult::RE_KEYFILE_OPEN_ERROR, keyErrorMsg);
+        return;
     }
 
     if (m_Database) {
+        flushPendingSave();
         delete m_Database;
     }
 
+    m_itemHandles.clear();
+    m_listModelItems.clear();
+    m_searchIndex.clear();
+    m_searchIndexBuilt = false;
+    m_searchSession = SearchSession();
+    m_searchJob = SearchJob();
+    m_stageTimer.start("open");
     KeePass2Reader reader;
     m_Database = reader.readDatabase(&file, masterKey);
+    // key transformation, decryption and parsing are all done within the reader
+    m_stageTimer.endStage("read, decrypt and parse", file.size());
 
     if (m_Database == Q_NULLPTR) {
         // an error occured during opening of the database
@@ -133,8 +293,8 @@ void Keepass2DatabaseInterface::slot_openDatabase(QString filePath, QString pass
         return;
     }
 
-    // currently Keepass 2 database support is limited to read only, so set it here explicitly
-    db_read_only = true;
+    m_filePath = filePath;
+    m_readOnly = db_read_only;
 
     // database was opened successfully
     if (db_read_only) {
@@ -142,9 +302,14 @@ void Keepass2DatabaseInterface::slot_openDatabase(QString filePath, QString pass
     } else {
         emit databaseOpened(DatabaseAccessResult::RE_OK, "");
     }
+    if (m_stageTimer.isEnabled()) {
+        emit stagesTimed(m_stageTimer.operation(), m_stageTimer.takeStages());
+    }
+    // index the entries for searching when the requests which are already queued are done
+    QTimer::singleShot(0, this, SLOT(slot_buildSearchIndex()));
 
     // load used encryption and KeyTransfRounds and sent to KdbDatabase object so that it is shown in UI database settings page
-    emit databaseCryptAlgorithmChanged(0); // Keepass2 only supports Rijndael_Cipher = 0
+    emit databaseCryptAlgorithmChanged(cryptAlgorithm(m_Database->cipher()));
     emit databaseKeyTransfRoundsChanged(m_Database->transformRounds());
 }
 
@@ -155,9 +320,15 @@ void Keepass2DatabaseInterface::slot_closeDatabase()
         emit errorOccured(DatabaseAccessResult::RE_DB_ALREADY_CLOSED, "");
         return;
     }
+    // write changes which are not saved yet
+    flushPendingSave();
 
     delete m_Database;
     m_Database = NULL;
+    m_searchIndex.clear();
+    m_searchIndexBuilt = false;
+    m_searchSession = SearchSession();
+    m_searchJob = SearchJob();
 
 // TODO delete .lock file
 
@@ -174,70 +345,89 @@ void Keepass2DatabaseInterface::slot_createNewDatabase(QString filePath, QString
 
 void Keepass2DatabaseInterface::slot_changePassKey(QString password, QString keyFile)
 {
+    Q_ASSERT(m_Database);
+    if (m_readOnly) {
+        emit errorOccured(DatabaseAccessResult::RE_DB_READ_ONLY, "");
+        return;
+    }
+    CompositeKey masterKey;
+    QString errorMsg;
+    if (!buildMasterKey(password, keyFile, masterKey, errorMsg)) {
+        emit errorOccured(DatabaseAccessResult::RE_KEYFILE_OPEN_ERROR, errorMsg);
+        return;
+    }
+    if (!m_Database->setKey(masterKey)) {
+        emit errorOccured(DatabaseAccessResult::RE_DB_SETPW_ERROR, "");
+        return;
+    }
+    // the database file must not stay encrypted with the old key, so it is written right away
+    scheduleSave();
+    flushPendingSave();
+    emit passwordChanged();
 }
 
 void Keepass2DatabaseInterface::slot_loadMasterGroups(bool registerListModel)
 {
     Q_ASSERT(m_Database);
 
-//    Uuid rootGroupId = Uuid(); // root group has list model ID 0
-    Uuid rootGroupId = m_Database->rootGroup()->uuid();
+    if (!registerListModel) {
+        // list models used in dialogs, e.g. for moving an entry, get the whole group tree but no entries,
+        // they are not registered because they are not updated
+        QList<KdbItem> items;
+        appendGroupTree(m_Database->rootGroup(), 0, items);
+        if (!items.isEmpty()) {
+            emit appendItemsToListModel(items, 0xffffffff);
+        }
+        emit masterGroupsLoaded(DatabaseAccessResult::RE_OK);
+        return;
+    }
+
+    // root group has list model ID 0
+    quint32 rootGroupId = 0;
 
     QList<Group*> masterGroups = m_Database->rootGroup()->children();
+    QList<KdbItem> items;
     for (int i = 0; i < masterGroups.count(); i++) {
         Group* masterGroup = masterGroups.at(i);
 //        qDebug() << "Mastergroup " << i << ": " << masterGroup->name();
 //        qDebug() << "Expanded: " << masterGroup->isExpanded();
 
-        int numberOfSubgroups = masterGroup->children().count();
-        int numberOfEntries = masterGroup->entries().count();
-
-        Uuid masterGroupId = masterGroup->uuid();
-//        qDebug() << "Uuid: " << masterGroupId.toByteArray();
-//        qDebug() << "toHex: " << masterGroupId.toHex();
-        if (registerListModel) {
-            // save modelId and master group only if needed
-            // i.e. save model list id for master group page and don't do it for list models used in dialogs
-            m_groups_modelId.insertMulti((const Uuid &)rootGroupId, (const Uuid &)masterGroupId);
-        }
-        emit appendItemToListModel(masterGroup->name(),                            // group name
-                                   QString("Subgroups: %1 | Entries: %2")
-                                   .arg(numberOfSubgroups)
-                                   .arg(numberOfEntries),                          // subtitle
-                                   masterGroupId.toHex(),                          // item id
-                                   (int)DatabaseItemType::GROUP,                   // item type
-                                   0,                                              // item level (0 = root, 1 = first level, etc.
-                                   rootGroupId.toHex());                           // list model of root group
+        // save modelId and master group
+        m_listModelItems.registerItem(rootGroupId, itemHandle(masterGroup));
+        items << groupItem(masterGroup);
     }
 
     QList<Entry*> masterEntries = m_Database->rootGroup()->entries();
     for (int i = 0; i < masterEntries.count(); i++) {
         Entry* entry = masterEntries.at(i);
-        Uuid itemId = entry->uuid();
         // only append to list model if item ID is valid
-        emit appendItemToListModel(entry->title(),                                 // group name
-                                   getUserAndPassword(entry),                      // subtitle
-                                   itemId.toHex(),                                 // item id
-                                   (int)DatabaseItemType::ENTRY,                   // item type
-                                   0,                                              // item level (not used here)
-                                   rootGroupId.toHex());                           // list model gets groupId as its unique ID (here 0 because of root group)
+        items << KdbItem(entry->title(),                                 // group name
+                         getUserAndPassword(entry),                      // subtitle
+                         itemHandle(entry),                              // item id
+                         (int)DatabaseItemType::ENTRY,                   // item type
+                         0);                                             // item level (not used here)
         // save modelId and entry
-        m_entries_modelId.insertMulti(rootGroupId, itemId);
+        m_listModelItems.registerItem(rootGroupId, itemHandle(entry));
+    }
+    // list model of root group gets all groups and entries at once
+    if (!items.isEmpty()) {
+        emit appendItemsToListModel(items, rootGroupId);
     }
     emit masterGroupsLoaded(DatabaseAccessResult::RE_OK);
 }
 
-void Keepass2DatabaseInterface::slot_loadGroupsAndEntries(QString groupId)
+void Keepass2DatabaseInterface::slot_loadGroupsAndEntries(quint32 groupId)
 {
     Q_ASSERT(m_Database);
     // load sub groups and entries
-    Uuid groupUuid = qString2Uuid(groupId);
-    Group* group = m_Database->resolveGroup(groupUuid);
+    Group* group = groupFromId(groupId);
+    if (Q_NULLPTR == group) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
+    quint32 groupHandle = itemHandle(group);
     QList<Group*> subGroups = group->children();
 
-//    qDebug() << "group uuid: " << groupUuid.toByteArray();
-//    qDebug() << "group toHex: " << groupUuid.toHex();
-
 /*
     if (m_setting_sortAlphabeticallyInListView) {
         subGroups = m_kdb3Database->sortedGroups();
@@ -247,19 +437,8 @@ void Keepass2DatabaseInterface::slot_loadGroupsAndEntries(QString groupId)
 */
 
     for (int i = 0; i < subGroups.count(); i++) {
-        Group* subGroup = subGroups.at(i);
-        int numberOfSubgroups = subGroup->children().count();
-        int numberOfEntries = subGroup->entries().count();
-        Uuid itemId = subGroup->uuid();
-        emit appendItemToListModel(subGroup->name(),                               // group name
-                                   QString("Subgroups: %1 | Entries: %2")
-                                   .arg(numberOfSubgroups).arg(numberOfEntries),   // subtitle
-                                   itemId.toHex(),                                 // item id
-                                   (int)DatabaseItemType::GROUP,                   // item type
-                                   0,                                              // item level (not used here)
-                                   groupId);                                       // list model gets groupId as its unique ID
         // save modelId and group
-        m_groups_modelId.insertMulti(groupUuid, itemId);
+        m_listModelItems.registerItem(groupHandle, itemHandle(subGroups.at(i)));
     }
 
     QList<Entry*> entries = group->entries();
@@ -271,80 +450,157 @@ void Keepass2DatabaseInterface::slot_loadGroupsAndEntries(QString groupId)
     }
 */
     for (int i = 0; i < entries.count(); i++) {
-        Entry* entry = entries.at(i);
-        Uuid itemId = entry->uuid();
-        emit appendItemToListModel(entry->title(),                                 // group name
-                                   getUserAndPassword(entry),                      // subtitle
-                                   itemId.toHex(),                                 // item id
-                                   (int)DatabaseItemType::ENTRY,                   // item type
-                                   0,                                              // item level (not used here)
-                                   groupId);                                       // list model gets groupId as its unique ID
         // save modelId and entry
-        m_entries_modelId.insertMulti(groupUuid, itemId);
+        m_listModelItems.registerItem(groupHandle, itemHandle(entries.at(i)));
     }
+    // list model gets groupId as its unique ID
+    sendItemsToListModel(subGroups, entries, false, groupId);
     emit groupsAndEntriesLoaded(DatabaseAccessResult::RE_OK);
 }
 
-void Keepass2DatabaseInterface::slot_loadEntry(QString entryId)
+void Keepass2DatabaseInterface::slot_loadEntry(quint32 entryId)
 {
     // get entry handler for entryId
-    Entry* entry = m_Database->resolveEntry(qString2Uuid(entryId));
+    Entry* entry = entryFromId(entryId);
     if (Q_NULLPTR == entry) {
-        qDebug() << "ERROR: Could not find entry for UUID: " << entryId;
-// TODO add error handling
-//        emit entryLoaded(DB_ENTRY_NOT_FOUND,...);
+        qDebug() << "ERROR: Could not find entry for ID: " << entryId;
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(entryId, 16));
         return;
-    } else {
-        QList<QString> keys; //entry->attributes()->customKeys();
-        QList<QString> values;
-
-        // First add default keys and values
-        keys.append(EntryAttributes::TitleKey);
-        keys.append(EntryAttributes::URLKey);
-        keys.append(EntryAttributes::UserNameKey);
-        keys.append(EntryAttributes::PasswordKey);
-        keys.append(EntryAttributes::NotesKey);
-        values.append(entry->title());
-        values.append(entry->url());
-        values.append(entry->username());
-        values.append(entry->password());
-        values.append(entry->notes());
-
-        // Now add additional custom keys and values
-        Q_FOREACH (const QString& key, entry->attributes()->customKeys()) {
-            keys.append(key);
-            values.append(entry->attributes()->value(key));
-        }
+    }
+    sendEntryToEntryObjects(entry, entryId);
+}
 
-        // send signal with all entry data to all connected entry objects
-        // each object will check with entryId if it needs to update the details
-        emit entryLoaded(DatabaseAccessResult::RE_OK,
-                         entryId,
-                         keys,
-                         values);
+void Keepass2DatabaseInterface::sendEntryToEntryObjects(Entry* entry, quint32 entryId)
+{
+    QList<QString> keys;
+    QList<QString> values;
+
+    // First add default keys and values
+    keys.append(EntryAttributes::TitleKey);
+    keys.append(EntryAttributes::URLKey);
+    keys.append(EntryAttributes::UserNameKey);
+    keys.append(EntryAttributes::PasswordKey);
+    keys.append(EntryAttributes::NotesKey);
+    values.append(entry->title());
+    values.append(entry->url());
+    values.append(entry->username());
+    values.append(entry->password());
+    values.append(entry->notes());
+
+    // Now add additional custom keys and values
+    Q_FOREACH (const QString& key, entry->attributes()->customKeys()) {
+        keys.append(key);
+        values.append(entry->attributes()->value(key));
     }
+
+    // send signal with all entry data to all connected entry objects
+    // each object will check with entryId if it needs to update the details
+    emit entryLoaded(DatabaseAccessResult::RE_OK,
+                     entryId,
+                     keys,
+                     values);
 }
 
-void Keepass2DatabaseInterface::slot_loadGroup(QString groupId)
+void Keepass2DatabaseInterface::slot_loadGroup(quint32 groupId)
 {
+    // get group handler for groupId
+    Group* group = groupFromId(groupId);
+    if (Q_NULLPTR == group) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
+    emit groupLoaded(DatabaseAccessResult::RE_OK, groupId, group->name());
 }
 
-void Keepass2DatabaseInterface::slot_saveGroup(QString groupId, QString title)
+void Keepass2DatabaseInterface::slot_saveGroup(quint32 groupId, QString title)
 {
+    Q_ASSERT(m_Database);
+
+    //  save changes on group details to database
+    Group* group = groupFromId(groupId);
+    // Master group (0) cannot be changed
+    if (Q_NULLPTR == group || group == m_Database->rootGroup()) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
+    group->setName(title);
+    if (!scheduleSave()) {
+        emit groupSaved(DatabaseAccessResult::RE_DB_SAVE_ERROR, groupId);
+        return;
+    }
+
+    // update all list models which contain the changed group
+    // groups and entries are shown in database order, so the position of the group does not change
+    KdbItem item = groupItem(group);
+    QList<quint32> modelIds = m_listModelItems.models(itemHandle(group));
+    for (int i = 0; i < modelIds.count(); i++) {
+        emit updateItemInListModel(item.m_name, item.m_subtitle, groupId, modelIds[i]);
+        updateItemInListModelWindow(groupId, modelIds[i]);
+    }
+    // signal to QML
+    emit groupSaved(DatabaseAccessResult::RE_OK, groupId);
 }
 
-void Keepass2DatabaseInterface::slot_unregisterListModel(QString modelId)
+void Keepass2DatabaseInterface::slot_unregisterListModel(quint32 modelId)
 {
     // delete all groups and entries which are associated with given modelId
-    m_groups_modelId.remove(qString2Uuid(modelId));
-    m_entries_modelId.remove(qString2Uuid(modelId));
+    m_listModelItems.unregisterModel(modelId);
+    m_listModelWindows.remove(modelId);
+    if (modelId == 0xfffffffe) {
+        // the search list model is gone, a running search is not needed anymore
+        m_searchSession.valid = false;
+        m_searchJob.running = false;
+    }
 }
 
-void Keepass2DatabaseInterface::slot_createNewGroup(QString title, quint32 iconId, QString parentGroupId)
+void Keepass2DatabaseInterface::slot_loadListModelPage(quint32 modelId, int firstRow, int count)
 {
+    // list model might have been unregistered or reloaded in the meantime
+    if (!m_listModelWindows.contains(modelId)) return;
+    emit listModelPageLoaded(firstRow, listModelPage(m_listModelWindows[modelId], firstRow, count), modelId);
 }
 
-void Keepass2DatabaseInterface::slot_saveEntry(QString entryId,
+void Keepass2DatabaseInterface::slot_createNewGroup(QString title, quint32 iconId, quint32 parentGroupId)
+{
+    Q_ASSERT(m_Database);
+
+    // get parent group handle and identify IDs of list model
+    Group* parentGroup = groupFromId(parentGroupId);
+    if (Q_NULLPTR == parentGroup) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(parentGroupId, 16));
+        return;
+    }
+
+    Group* newGroup = new Group(); // ownership will be given to parent group
+    newGroup->setUuid(Uuid::random());
+    newGroup->setName(title);
+    newGroup->setIcon(iconId);
+    newGroup->setParent(parentGroup);
+    quint32 newGroupId = itemHandle(newGroup);
+    // schedule saving changes to database
+    if (!scheduleSave()) {
+        emit newGroupCreated(DatabaseAccessResult::RE_DB_SAVE_ERROR, newGroupId);
+        return;
+    }
+
+    // new groups are put behind the last group in the list model of the parent group
+    emit appendItemToListModel(title,                                          // group name
+                               "Subgroups: 0 | Entries: 0",                    // subtitle
+                               newGroupId,                                     // item id
+                               DatabaseItemType::GROUP,                        // item type
+                               0,                                              // item level (not used here)
+                               parentGroupId);                                 // for distinguishing different models
+    insertItemInListModelWindow(newGroupId, DatabaseItemType::GROUP, parentGroupId);
+    // save modelid and group
+    m_listModelItems.registerItem(itemHandle(parentGroup), itemHandle(newGroup));
+
+    // update all grandparent groups subtitle in UI
+    updateGrandParentGroupInListModel(parentGroup);
+    // signal to QML
+    emit newGroupCreated(DatabaseAccessResult::RE_OK, newGroupId);
+}
+
+void Keepass2DatabaseInterface::slot_saveEntry(quint32 entryId,
                                         QString title,
                                         QString url,
                                         QString username,
@@ -352,6 +608,41 @@ void Keepass2DatabaseInterface::slot_saveEntry(QString entryId,
                                         QString comment)
 {
     Q_ASSERT(m_Database);
+    //  save changes on entry details to database
+    Entry* entry = entryFromId(entryId);
+    if (Q_NULLPTR == entry) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(entryId, 16));
+        return;
+    }
+
+    // the old state of the entry is kept in its history like KeePassX does it
+    entry->beginUpdate();
+    entry->setTitle(title);
+    entry->setUrl(url);
+    entry->setUsername(username);
+    entry->setPassword(password);
+    entry->setNotes(comment);
+    entry->endUpdate();
+    updateSearchIndex(entry);
+    // schedule saving changes to database and send signal with result
+    if (!scheduleSave()) {
+        emit entrySaved(DatabaseAccessResult::RE_DB_SAVE_ERROR, entryId);
+        return;
+    }
+
+    // update entry item in list models
+    QList<quint32> modelIds = m_listModelItems.models(itemHandle(entry));
+    for (int i = 0; i < modelIds.count(); i++) {
+        emit updateItemInListModel(title,                                       // entry name
+                                   getUserAndPassword(entry),                   // subtitle
+                                   entryId,                                     // identifier for item in list model
+                                   modelIds[i]);                                // identifier for list model
+        updateItemInListModelWindow(entryId, modelIds[i]);
+    }
+    // signal to QML
+    emit entrySaved(DatabaseAccessResult::RE_OK, entryId);
+    // update all entry objects, there might be two instances open
+    sendEntryToEntryObjects(entry, entryId);
 }
 
 void Keepass2DatabaseInterface::slot_createNewEntry(QString title,
@@ -359,68 +650,648 @@ void Keepass2DatabaseInterface::slot_createNewEntry(QString title,
                                              QString username,
                                              QString password,
                                              QString comment,
-                                             QString parentGroupId)
+                                             quint32 parentGroupId)
 {
+    Q_ASSERT(m_Database);
+    // create new entry in specified group
+    Group* parentGroup = groupFromId(parentGroupId);
+    if (Q_NULLPTR == parentGroup) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(parentGroupId, 16));
+        return;
+    }
+    Entry* newEntry = new Entry(); // ownership will be given to parent group
+    newEntry->setUuid(Uuid::random());
+    newEntry->setTitle(title);
+    newEntry->setUrl(url);
+    newEntry->setUsername(username);
+    newEntry->setPassword(password);
+    newEntry->setNotes(comment);
+    newEntry->setGroup(parentGroup);
+    updateSearchIndex(newEntry);
+    quint32 newEntryId = itemHandle(newEntry);
+    // schedule saving changes to database
+    if (!scheduleSave()) {
+        emit newEntryCreated(DatabaseAccessResult::RE_DB_SAVE_ERROR, newEntryId);
+        return;
+    }
+
+    // add entry to list model in order to update UI by sending signal to list models with identifier modelId
+    emit appendItemToListModel(title,                                          // title
+                               getUserAndPassword(newEntry),                   // subtitle
+                               newEntryId,                                     // item id
+                               DatabaseItemType::ENTRY,                        // item type
+                               0,                                              // item level (not used here)
+                               parentGroupId);                                 // id of list model where to put this entry in
+    insertItemInListModelWindow(newEntryId, DatabaseItemType::ENTRY, parentGroupId);
+    // save modelId and entry
+    m_listModelItems.registerItem(itemHandle(parentGroup), itemHandle(newEntry));
+
+    // update all grandparent groups subtitle, ie. entries counter has to be updated in UI
+    updateGrandParentGroupInListModel(parentGroup);
+    // signal to QML
+    emit newEntryCreated(DatabaseAccessResult::RE_OK, newEntryId);
 }
 
-void Keepass2DatabaseInterface::slot_deleteGroup(QString groupId)
+void Keepass2DatabaseInterface::slot_deleteGroup(quint32 groupId)
 {
+    Q_ASSERT(m_Database);
+    // get group handles
+    Group* group = groupFromId(groupId);
+    if (Q_NULLPTR == group || group == m_Database->rootGroup()) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
+    Group* parentGroup = group->parentGroup();
+    // drop the group with all its subgroups and entries from list models which are filled page by page
+    removeGroupFromListModelWindows(group);
+    // list models which show the group, needed after its handle is released
+    QList<quint32> modelIds = m_listModelItems.models(groupId);
+    // the group might be deleted and its memory used for new items later on
+    releaseItemHandles(group);
+    invalidateSearchResult();
+    // move group to the recycle bin or delete it if recycle bin is disabled or it is in there already
+    Group* recycleBin = m_Database->metadata()->recycleBin();
+    m_Database->recycleGroup(group);
+    updateRecycleBinInListModel(recycleBin);
+    // schedule saving changes to database
+    if (!scheduleSave()) {
+        emit groupDeleted(DatabaseAccessResult::RE_DB_SAVE_ERROR, groupId);
+        return;
+    }
+
+    // remove group from the list models where it was added
+    emit deleteItemInListModel(groupId, modelIds);
+
+    // update all grandparent groups subtitle, ie. subgroup counter has to be updated in UI
+    updateGrandParentGroupInListModel(parentGroup);
+    // signal to QML
+    emit groupDeleted(DatabaseAccessResult::RE_OK, groupId);
 }
 
-//void Keepass2DatabaseInterface::updateGrandParentGroupInListModel(IGroupHandle* parentGroup)
-//{
-//}
+/*!
+\brief Show the recycle bin in the list model of its parent group after a group or entry was recycled
+
+The keepassx library creates the recycle bin below the root group when the first item is deleted,
+so it is added to the list model then. Otherwise only its counters are updated.
+
+\param oldRecycleBin The recycle bin before the item was recycled, might be Q_NULLPTR
+*/
+void Keepass2DatabaseInterface::updateRecycleBinInListModel(Group* oldRecycleBin)
+{
+    Group* recycleBin = m_Database->metadata()->recycleBin();
+    if (Q_NULLPTR == recycleBin) return;
+    if (recycleBin == oldRecycleBin) {
+        updateGrandParentGroupInListModel(recycleBin);
+        return;
+    }
+
+    Group* parentGroup = recycleBin->parentGroup();
+    quint32 parentGroupId = itemHandle(parentGroup);
+    KdbItem item = groupItem(recycleBin);
+    emit appendItemToListModel(item.m_name,                                     // group name
+                               item.m_subtitle,                                 // subtitle
+                               item.m_id,                                       // item id
+                               DatabaseItemType::GROUP,                         // item type
+                               0,                                               // item level (not used here)
+                               parentGroupId);                                  // for distinguishing different models
+    insertItemInListModelWindow(item.m_id, DatabaseItemType::GROUP, parentGroupId);
+    // save modelid and group
+    m_listModelItems.registerItem(itemHandle(parentGroup), itemHandle(recycleBin));
+    updateGrandParentGroupInListModel(parentGroup);
+}
 
-void Keepass2DatabaseInterface::slot_deleteEntry(QString entryId)
+void Keepass2DatabaseInterface::updateGrandParentGroupInListModel(Group* parentGroup)
 {
+    Q_ASSERT(m_Database);
+    // root group is not shown as an item in any list model
+    if (parentGroup == m_Database->rootGroup()) return;
+
+    KdbItem item = groupItem(parentGroup);
+    quint32 modelId = itemHandle(parentGroup->parentGroup());
+    emit updateItemInListModel(item.m_name,                                     // group name
+                               item.m_subtitle,                                 // subtitle
+                               item.m_id,                                       // identifier for group item in list model
+                               modelId);                                        // identifier for list model
+    updateItemInListModelWindow(item.m_id, modelId);
 }
 
-void Keepass2DatabaseInterface::slot_moveEntry(QString entryId, QString newGroupId)
+void Keepass2DatabaseInterface::slot_deleteEntry(quint32 entryId)
 {
+    Q_ASSERT(m_Database);
+    // get handles
+    Entry* entry = entryFromId(entryId);
+    if (Q_NULLPTR == entry) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(entryId, 16));
+        return;
+    }
+    Group* parentGroup = entry->group();
+    Q_ASSERT(parentGroup);
+
+    // list models which show the entry, needed after its handle is released
+    QList<quint32> modelIds = m_listModelItems.models(entryId);
+    m_listModelItems.unregisterItem(itemHandle(entry));
+    m_searchIndex.remove(itemHandle(entry));
+    invalidateSearchResult();
+    m_itemHandles.remove(entry);
+    // move entry to the recycle bin or delete it if recycle bin is disabled or it is in there already
+    Group* recycleBin = m_Database->metadata()->recycleBin();
+    m_Database->recycleEntry(entry);
+    updateRecycleBinInListModel(recycleBin);
+    // schedule saving changes to database
+    if (!scheduleSave()) {
+        emit entryDeleted(DatabaseAccessResult::RE_DB_SAVE_ERROR, entryId);
+        return;
+    }
+
+    // remove entry from the list models where it was added
+    emit deleteItemInListModel(entryId, modelIds);
+    removeItemFromListModelWindows(entryId);
+    // update all grandparent groups subtitle, ie. entries counter has to be updated in UI
+    updateGrandParentGroupInListModel(parentGroup);
+    // signal to QML
+    emit entryDeleted(DatabaseAccessResult::RE_OK, entryId);
 }
 
-void Keepass2DatabaseInterface::slot_moveGroup(QString groupId, QString newParentGroupId)
+void Keepass2DatabaseInterface::slot_moveEntry(quint32 entryId, quint32 newGroupId)
 {
+    Q_ASSERT(m_Database);
+    Entry* entry = entryFromId(entryId);
+    if (Q_NULLPTR == entry) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(entryId, 16));
+        return;
+    }
+    Group* parentGroup = entry->group();
+    Q_ASSERT(parentGroup);
+    Group* newGroup = groupFromId(newGroupId);
+    if (Q_NULLPTR == newGroup) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(newGroupId, 16));
+        return;
+    }
+
+    // move entry to new group within the database
+    entry->setGroup(newGroup);
+    // the entry might have left or entered the group of the last search
+    invalidateSearchResult();
+    // schedule saving changes to database
+    if (!scheduleSave()) {
+        emit entryMoved(DatabaseAccessResult::RE_DB_SAVE_ERROR, entryId);
+        return;
+    }
+
+    // remove entry from the list models where it was added
+    emit deleteItemInListModel(entryId, m_listModelItems.models(entryId));
+    removeItemFromListModelWindows(entryId);
+    m_listModelItems.unregisterItem(itemHandle(entry));
+    // update all grandparent groups subtitle, ie. entries counter has to be updated in UI
+    updateGrandParentGroupInListModel(parentGroup);
+
+    // add entry item in list model of new group if this group is actually visible in UI
+    if (m_listModelItems.containsModel(itemHandle(newGroup)) || m_listModelWindows.contains(newGroupId)) {
+        // register entry to list model of parent group
+        m_listModelItems.registerItem(itemHandle(newGroup), itemHandle(entry));
+        emit appendItemToListModel(entry->title(),                             // entry name
+                                   getUserAndPassword(entry),                  // subtitle
+                                   entryId,                                    // identifier for entry item in list model
+                                   DatabaseItemType::ENTRY,                    // item type
+                                   0,                                          // item level (not used here)
+                                   newGroupId);                                // identifier for list model where this item should be inserted
+        insertItemInListModelWindow(entryId, DatabaseItemType::ENTRY, newGroupId);
+    }
+    // update subtitle of parent list model where password entry was moved to
+    updateGrandParentGroupInListModel(newGroup);
+    // signal to QML
+    emit entryMoved(DatabaseAccessResult::RE_OK, entryId);
 }
 
-void Keepass2DatabaseInterface::slot_searchEntries(QString searchString, QString rootGroupId)
+void Keepass2DatabaseInterface::slot_moveGroup(quint32 groupId, quint32 newParentGroupId)
 {
-    Group* searchGroup;
-    if (rootGroupId.compare("0") == 0) {
-        searchGroup = m_Database->rootGroup();
-    } else {
-        searchGroup = m_Database->resolveGroup(qString2Uuid(rootGroupId));
-    }
-    Q_ASSERT(searchGroup);
-    if (searchGroup != Q_NULLPTR) {
-        EntrySearcher searcher;
-        QString searchId = uInt2QString(0xfffffffe);
-        Uuid searchUuid = qString2Uuid(searchId);
-        Q_FOREACH (Entry* entry, searcher.search(searchString, searchGroup, Qt::CaseInsensitive)) {
-            // update list model with found entries
-            if (m_setting_sortAlphabeticallyInListView) {
-                emit addItemToListModelSorted(entry->title(),                              // entry name
-                                              getUserAndPassword(entry),                   // subtitle
-                                              entry->uuid().toHex(),                       // item id
-                                              DatabaseItemType::ENTRY,                     // item type
-                                              0,                                           // item level (not used here)
-                                              searchId);                                   // specifying model where entry should be added (search list model gets 0xfffffffe)
-            } else {
-                emit appendItemToListModel(entry->title(),                                 // entry name
-                                           getUserAndPassword(entry),                      // subtitle
-                                           entry->uuid().toHex(),                          // item id
-                                           DatabaseItemType::ENTRY,                        // item type
-                                           0,                                              // item level (not used here)
-                                           searchId);                                      // specifying model where entry should be added (search list model gets 0xfffffffe)
+    Q_ASSERT(m_Database);
+    Group* group = groupFromId(groupId);
+    if (Q_NULLPTR == group || group == m_Database->rootGroup()) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(groupId, 16));
+        return;
+    }
+    Group* parentGroup = group->parentGroup();
+    Q_ASSERT(parentGroup);
+    Group* newParentGroup = groupFromId(newParentGroupId);
+    // a group cannot be moved into itself or into one of its subgroups
+    for (Group* ancestor = newParentGroup; ancestor; ancestor = ancestor->parentGroup()) {
+        if (ancestor == group) {
+            newParentGroup = Q_NULLPTR;
+            break;
+        }
+    }
+    if (Q_NULLPTR == newParentGroup) {
+        emit errorOccured(DatabaseAccessResult::RE_ERR_ITEM_NOT_FOUND, QString::number(newParentGroupId, 16));
+        return;
+    }
+
+    // move group with all its subgroups and entries within the database
+    group->setParent(newParentGroup);
+    // entries of the group might have left or entered the group of the last search
+    invalidateSearchResult();
+    // schedule saving changes to database
+    if (!scheduleSave()) {
+        emit groupMoved(DatabaseAccessResult::RE_DB_SAVE_ERROR, groupId);
+        return;
+    }
+
+    // remove group from the list models where it was added
+    emit deleteItemInListModel(groupId, m_listModelItems.models(groupId));
+    removeItemFromListModelWindows(groupId);
+    m_listModelItems.unregisterItem(itemHandle(group));
+    // update all grandparent groups subtitle, ie. subgroup counter has to be updated in UI
+    updateGrandParentGroupInListModel(parentGroup);
+
+    // add group item in list model of new parent group if this group is actually visible in UI
+    if (m_listModelItems.containsModel(itemHandle(newParentGroup)) || m_listModelWindows.contains(newParentGroupId)) {
+        // register group to list model of new parent group
+        m_listModelItems.registerItem(itemHandle(newParentGroup), itemHandle(group));
+        KdbItem item = groupItem(group);
+        emit appendItemToListModel(item.m_name,                                 // group name
+                                   item.m_subtitle,                             // subtitle
+                                   groupId,                                     // identifier for group item in list model
+                                   DatabaseItemType::GROUP,                     // item type
+                                   0,                                           // item level (not used here)
+                                   newParentGroupId);                           // identifier for list model where this item should be inserted
+        insertItemInListModelWindow(groupId, DatabaseItemType::GROUP, newParentGroupId);
+    }
+    // update subtitle of parent list model where the group was moved to
+    updateGrandParentGroupInListModel(newParentGroup);
+    // signal to QML
+    emit groupMoved(DatabaseAccessResult::RE_OK, groupId);
+}
+
+void Keepass2DatabaseInterface::slot_searchEntries(QString searchString, quint32 rootGroupId)
+{
+    // replace a running search, the new one starts when the requests which are already queued are done,
+    // so that of the search requests which are queued while typing only the last one is performed
+    m_searchJob = SearchJob();
+    m_searchJob.generation = ++m_searchGeneration;
+    m_searchJob.running = true;
+    m_searchJob.searchString = searchString;
+    m_searchJob.rootGroupId = rootGroupId;
+    QMetaObject::invokeMethod(this, "slot_continueSearch", Qt::QueuedConnection, Q_ARG(uint, m_searchJob.generation));
+}
+
+void Keepass2DatabaseInterface::slot_continueSearch(uint generation)
+{
+    // chunks of a replaced search are dropped
+    if (generation != m_searchJob.generation || !m_searchJob.running) return;
+    Q_ASSERT(m_Database);
+
+    // the group might have been deleted between the chunks
+    Group* searchGroup = groupFromId(m_searchJob.rootGroupId);
+    if (searchGroup == Q_NULLPTR) {
+        m_searchJob.running = false;
+        emit searchEntriesCompleted(DatabaseAccessResult::RE_ERR_SEARCH);
+        return;
+    }
+    quint32 searchId = 0xfffffffe;
+    if (!m_searchJob.started) {
+        m_stageTimer.start("search");
+        // like EntrySearcher each word of the search string must be found in one of the fields
+        m_searchJob.words = m_searchJob.searchString.split(QRegExp("\\s"), QString::SkipEmptyParts);
+        if (refineSearch(m_searchJob.searchString, m_searchJob.rootGroupId, m_searchJob.words)) {
+            m_searchJob.running = false;
+            m_stageTimer.endStage("refine");
+            emit searchEntriesCompleted(DatabaseAccessResult::RE_OK);
+            if (m_stageTimer.isEnabled()) {
+                emit stagesTimed(m_stageTimer.operation(), m_stageTimer.takeStages());
             }
+            return;
+        }
+        slot_buildSearchIndex();
+        if (searchGroup->resolveSearchingEnabled()) {
+            m_searchJob.candidates = m_searchIndex.candidates(m_searchJob.words);
+        }
+        m_searchJob.started = true;
+        // results of a previous search are replaced
+        m_searchSession.valid = false;
+        m_listModelItems.unregisterModel(0xfffffffe);
+        m_listModelWindows.remove(searchId);
+        emit clearListModel(searchId);
+    }
+
+    // check the next chunk of entries
+    QList<quint32> found = m_searchIndex.filter(m_searchJob.candidates.mid(m_searchJob.position, SEARCH_CHUNK_SIZE),
+                                                m_searchJob.words);
+    m_searchJob.position += SEARCH_CHUNK_SIZE;
+    QList<Entry*> foundEntries;
+    for (int i = 0; i < found.count(); i++) {
+        Entry* entry = (Entry*)m_itemHandles.value(found[i], DatabaseItemType::ENTRY);
+        if (entry && isInSearchScope(entry, searchGroup)) {
+            foundEntries << entry;
             // save modelId and entry
-            m_entries_modelId.insertMulti(searchUuid, entry->uuid());
+            m_listModelItems.registerItem(0xfffffffe, found[i]);
+            m_searchJob.itemIds << found[i];
+        }
+    }
+    // found entries are shown right away unless there are so many that the list model gets them page by page
+    if (!foundEntries.isEmpty() && m_searchJob.itemIds.count() <= LIST_MODEL_WINDOW_THRESHOLD) {
+        QList<KdbItem> items;
+        for (int i = 0; i < foundEntries.count(); i++) {
+            items << entryItem(foundEntries.at(i));
+        }
+        if (m_setting_sortAlphabeticallyInListView) {
+            emit addItemsToListModelSorted(items, searchId);
+        } else {
+            emit appendItemsToListModel(items, searchId);
+        }
+    }
+    if (m_searchJob.position < m_searchJob.candidates.count()) {
+        // let other requests in before the next chunk
+        QMetaObject::invokeMethod(this, "slot_continueSearch", Qt::QueuedConnection, Q_ARG(uint, generation));
+        return;
+    }
+
+    // search is finished
+    m_searchJob.running = false;
+    m_stageTimer.endStage("search");
+    if (m_searchJob.itemIds.count() > LIST_MODEL_WINDOW_THRESHOLD) {
+        QList<Entry*> entries;
+        for (int i = 0; i < m_searchJob.itemIds.count(); i++) {
+            Entry* entry = (Entry*)m_itemHandles.value(m_searchJob.itemIds[i], DatabaseItemType::ENTRY);
+            if (entry) {
+                entries << entry;
+            }
+        }
+        // update list model with found entries
+        // specifying model where entries should be added (search list model gets 0xfffffffe)
+        sendItemsToListModel(QList<Group*>(), entries, m_setting_sortAlphabeticallyInListView, searchId);
+        m_stageTimer.endStage("send results");
+    }
+    m_searchSession.valid = !m_searchJob.databaseChanged;
+    m_searchSession.searchString = m_searchJob.searchString;
+    m_searchSession.rootGroupId = m_searchJob.rootGroupId;
+    m_searchSession.itemIds = m_searchJob.itemIds;
+    // signal to QML
+    emit searchEntriesCompleted(DatabaseAccessResult::RE_OK);
+    if (m_stageTimer.isEnabled()) {
+        emit stagesTimed(m_stageTimer.operation(), m_stageTimer.takeStages());
+    }
+}
+
+KdbItem Keepass2DatabaseInterface::groupItem(Group* group)
+{
+    return KdbItem(group->name(),                                   // group name
+                   QString("Subgroups: %1 | Entries: %2")
+                   .arg(group->children().count())
+                   .arg(group->entries().count()),                  // subtitle
+                   itemHandle(group),                               // item id
+                   (int)DatabaseItemType::GROUP,                    // item type
+                   0);                                              // item level (not used here)
+}
+
+void Keepass2DatabaseInterface::appendGroupTree(Group* parentGroup, int itemLevel, QList<KdbItem>& items)
+{
+    // groups are listed in tree order, the item level tells how deep a group is in the tree
+    QList<Group*> children = parentGroup->children();
+    for (int i = 0; i < children.count(); i++) {
+        Group* group = children.at(i);
+        // the recycle bin is not offered as a target, items are moved in there by deleting them
+        if (group == m_Database->metadata()->recycleBin()) continue;
+        KdbItem item = groupItem(group);
+        item.m_itemLevel = itemLevel;
+        items << item;
+        appendGroupTree(group, itemLevel + 1, items);
+    }
+}
+
+KdbItem Keepass2DatabaseInterface::entryItem(Entry* entry)
+{
+    return KdbItem(entry->title(),                                  // entry name
+                   getUserAndPassword(entry),                       // subtitle
+                   itemHandle(entry),                               // item id
+                   (int)DatabaseItemType::ENTRY,                    // item type
+                   0);                                              // item level (not used here)
+}
+
+/*!
+\brief Send groups and entries to a list model
+
+Small lists are sent to the list model at once. If there are more than
+LIST_MODEL_WINDOW_THRESHOLD items only their ids are kept in a
+ListModelWindow and the list model gets the first page of items. The other
+pages are created on request in slot_loadListModelPage().
+
+\param sortEntries Entries are not sorted yet and need to be sorted alphabetically
+*/
+void Keepass2DatabaseInterface::sendItemsToListModel(const QList<Group*>& groups,
+                                                     const QList<Entry*>& entries,
+                                                     bool sortEntries,
+                                                     quint32 modelId)
+{
+    m_listModelWindows.remove(modelId);
+    int numItems = groups.count() + entries.count();
+    if (numItems == 0) return;
+
+    if (numItems <= LIST_MODEL_WINDOW_THRESHOLD) {
+        QList<KdbItem> items;
+        for (int i = 0; i < groups.count(); i++) {
+            items << groupItem(groups.at(i));
+        }
+        for (int i = 0; i < entries.count(); i++) {
+            items << entryItem(entries.at(i));
+        }
+        if (sortEntries) {
+            emit addItemsToListModelSorted(items, modelId);
+        } else {
+            emit appendItemsToListModel(items, modelId);
+        }
+        return;
+    }
+
+    ListModelWindow window;
+    for (int i = 0; i < groups.count(); i++) {
+        window.itemIds << itemHandle(groups.at(i));
+    }
+    window.numGroups = groups.count();
+    if (sortEntries) {
+        QList<ListModelSortKey> keys;
+        for (int i = 0; i < entries.count(); i++) {
+            ListModelSortKey key;
+            key.title = KdbItem::sortKey(entries.at(i)->title());
+            key.itemId = itemHandle(entries.at(i));
+            keys << key;
+        }
+        qStableSort(keys);
+        for (int i = 0; i < keys.count(); i++) {
+            window.itemIds << keys[i].itemId;
         }
-        // signal to QML
-        emit searchEntriesCompleted(DatabaseAccessResult::RE_OK);
     } else {
-        emit searchEntriesCompleted(DatabaseAccessResult::RE_ERR_SEARCH);
+        for (int i = 0; i < entries.count(); i++) {
+            window.itemIds << itemHandle(entries.at(i));
+        }
+    }
+    m_listModelWindows.insert(modelId, window);
+    emit listModelWindowLoaded(listModelPage(window, 0, LIST_MODEL_PAGE_SIZE), numItems, modelId);
+}
+
+QList<KdbItem> Keepass2DatabaseInterface::listModelPage(const ListModelWindow& window, int firstRow, int count)
+{
+    QList<KdbItem> items;
+    int end = qMin(firstRow + count, window.itemIds.count());
+    for (int row = qMax(firstRow, 0); row < end; row++) {
+        if (row < window.numGroups) {
+            Group* group = groupFromId(window.itemIds[row]);
+            items << (group ? groupItem(group) : KdbItem());
+        } else {
+            Entry* entry = entryFromId(window.itemIds[row]);
+            items << (entry ? entryItem(entry) : KdbItem());
+        }
+    }
+    return items;
+}
+
+void Keepass2DatabaseInterface::insertItemInListModelWindow(quint32 itemId, int itemType, quint32 modelId)
+{
+    if (!m_listModelWindows.contains(modelId)) return;
+    ListModelWindow& window = m_listModelWindows[modelId];
+    // items are shown in database order, so groups are put behind the last group and entries at the end
+    int row = window.itemIds.count();
+    if (itemType == DatabaseItemType::GROUP) {
+        row = window.numGroups;
+        ++window.numGroups;
+    }
+    window.itemIds.insert(row, itemId);
+    emit itemInsertedInListModelWindow(row, modelId);
+}
+
+void Keepass2DatabaseInterface::updateItemInListModelWindow(quint32 itemId, quint32 modelId)
+{
+    if (!m_listModelWindows.contains(modelId)) return;
+    int row = m_listModelWindows[modelId].itemIds.indexOf(itemId);
+    if (row >= 0) {
+        emit itemChangedInListModelWindow(row, modelId);
+    }
+}
+
+void Keepass2DatabaseInterface::removeItemFromListModelWindows(quint32 itemId)
+{
+    QHash<quint32, ListModelWindow>::iterator it;
+    for (it = m_listModelWindows.begin(); it != m_listModelWindows.end(); ++it) {
+        int row = it.value().itemIds.indexOf(itemId);
+        if (row >= 0) {
+            it.value().itemIds.removeAt(row);
+            if (row < it.value().numGroups) {
+                --it.value().numGroups;
+            }
+            emit itemRemovedFromListModelWindow(row, it.key());
+        }
+    }
+}
+
+void Keepass2DatabaseInterface::removeGroupFromListModelWindows(Group* group)
+{
+    if (m_listModelWindows.isEmpty()) return;
+    QList<Group*> children = group->children();
+    for (int i = 0; i < children.count(); i++) {
+        removeGroupFromListModelWindows(children.at(i));
+    }
+    QList<Entry*> entries = group->entries();
+    for (int i = 0; i < entries.count(); i++) {
+        removeItemFromListModelWindows(itemHandle(entries.at(i)));
+    }
+    removeItemFromListModelWindows(itemHandle(group));
+}
+
+void Keepass2DatabaseInterface::releaseItemHandles(Group* group)
+{
+    QList<Group*> children = group->children();
+    for (int i = 0; i < children.count(); i++) {
+        releaseItemHandles(children.at(i));
+    }
+    QList<Entry*> entries = group->entries();
+    for (int i = 0; i < entries.count(); i++) {
+        m_listModelItems.unregisterItem(itemHandle(entries.at(i)));
+        m_searchIndex.remove(itemHandle(entries.at(i)));
+        m_itemHandles.remove(entries.at(i));
+    }
+    m_listModelItems.unregisterItem(itemHandle(group));
+    m_itemHandles.remove(group);
+}
+
+bool Keepass2DatabaseInterface::refineSearch(const QString& searchString, quint32 rootGroupId, const QStringList& words)
+{
+    if (!m_searchSession.isRefinedBy(searchString, rootGroupId)) return false;
+    slot_buildSearchIndex();
+    // the new search string contains the last one, so only entries of the last result can still match
+    QList<quint32> found = m_searchIndex.filter(m_searchSession.itemIds, words);
+    QSet<quint32> removedIds;
+    for (int i = 0, j = 0; i < m_searchSession.itemIds.count(); i++) {
+        // filter() keeps the order, so the entries which are gone are found in one pass
+        quint32 entryHandle = m_searchSession.itemIds[i];
+        if (j < found.count() && found[j] == entryHandle) {
+            ++j;
+            continue;
+        }
+        removedIds.insert(entryHandle);
+        m_listModelItems.unregisterItem(0xfffffffe, entryHandle);
+    }
+    m_searchSession.searchString = searchString;
+    m_searchSession.itemIds = found;
+    if (removedIds.isEmpty()) return true;
+
+    quint32 searchModelId = 0xfffffffe;
+    if (m_listModelWindows.contains(searchModelId)) {
+        // go backwards so that the rows which are still to be checked do not change
+        ListModelWindow& window = m_listModelWindows[searchModelId];
+        for (int row = window.itemIds.count() - 1; row >= 0; row--) {
+            if (removedIds.contains(window.itemIds[row])) {
+                window.itemIds.removeAt(row);
+                emit itemRemovedFromListModelWindow(row, searchModelId);
+            }
+        }
+    } else {
+        emit deleteItemsInListModel(removedIds.toList(), searchModelId);
+    }
+    return true;
+}
+
+void Keepass2DatabaseInterface::slot_buildSearchIndex()
+{
+    if (!m_Database || m_searchIndexBuilt) return;
+    QList<Entry*> entries = m_Database->rootGroup()->entriesRecursive();
+    for (int i = 0; i < entries.count(); i++) {
+        m_searchIndex.insert(itemHandle(entries.at(i)), searchIndexFields(entries.at(i)));
     }
+    m_searchIndexBuilt = true;
+}
+
+QStringList Keepass2DatabaseInterface::searchIndexFields(Entry* entry)
+{
+    // same fields which EntrySearcher looks at
+    QStringList fields;
+    fields << entry->title() << entry->username() << entry->url() << entry->notes();
+    return fields;
+}
+
+void Keepass2DatabaseInterface::updateSearchIndex(Entry* entry)
+{
+    // until the index is built the entry will be added together with all others
+    if (m_searchIndexBuilt) {
+        m_searchIndex.insert(itemHandle(entry), searchIndexFields(entry));
+    }
+    // the changed entry might match the next search string although it was not in the last result
+    invalidateSearchResult();
+}
+
+bool Keepass2DatabaseInterface::isInSearchScope(Entry* entry, Group* searchGroup)
+{
+    // like EntrySearcher skip entries from outside of the searched group and from groups which
+    // are excluded from searching, e.g. the recycle bin
+    Group* group = entry->group();
+    while (group && group != searchGroup && group->searchingEnabled() != Group::Disable) {
+        group = group->parentGroup();
+    }
+    return group == searchGroup;
+}
+
+void Keepass2DatabaseInterface::invalidateSearchResult()
+{
+    m_searchSession.valid = false;
+    m_searchJob.databaseChanged = true;
 }
 
 inline QString Keepass2DatabaseInterface::getUserAndPassword(Entry* entry)
@@ -439,52 +1310,123 @@ inline QString Keepass2DatabaseInterface::getUserAndPassword(Entry* entry)
 }
 
 /*!
-\brief Convert QString to Uuid
-
-This function converts a 16 character long QString into a Uuid. If the
-conversion is not successful it emits signal errorOccured with parameter
-RE_ERR_QSTRING_TO_UUID. That happens if the QString value is not exactly 16
-characters long.
+\brief Get the handle of a group or entry
 
-\param QString value to be converted to Uuid
-\return Uuid representation of the QString content or
-        an empty Uuid if an error occured during conversion
+The handle is used as compact ID of the item in the list models and in QML
+instead of the Uuid of the item, so that looking up an item does not need to
+search the whole group tree. The root group has the handle 0.
 */
-inline Uuid Keepass2DatabaseInterface::qString2Uuid(QString value)
+quint32 Keepass2DatabaseInterface::itemHandle(Group* group)
 {
-    QByteArray baValue = QByteArray::fromHex(value.toLatin1());
-    if (baValue.size() == Uuid::Length) {
-        return Uuid(baValue);
-    } else {
-        emit errorOccured(DatabaseAccessResult::RE_ERR_QSTRING_TO_UUID, value);
-        return Uuid();
+    if (group == m_Database->rootGroup()) {
+        return 0;
     }
+    return m_itemHandles.insert(group, DatabaseItemType::GROUP);
+}
+
+quint32 Keepass2DatabaseInterface::itemHandle(Entry* entry)
+{
+    return m_itemHandles.insert(entry, DatabaseItemType::ENTRY);
 }
 
 /*!
-\brief Convert integer number to QString
+\brief Get the group for an ID which was handed out by itemHandle()
 
-The integer number is converted into a 4 byte long hexadecimal QString.
+\return Q_NULLPTR if the group does not exist anymore
+*/
+Group* Keepass2DatabaseInterface::groupFromId(quint32 groupId)
+{
+    if (groupId == 0) {
+        return m_Database->rootGroup();
+    }
+    return (Group*)m_itemHandles.value(groupId, DatabaseItemType::GROUP);
+}
 
-\param value This is the integer value which shall be converted to QString
+/*!
+\brief Get the entry for an ID which was handed out by itemHandle()
 
-\return Hexadecimal QString representation of the integer number
+\return Q_NULLPTR if the entry does not exist anymore
 */
-inline QString Keepass2DatabaseInterface::uInt2QString(uint value)
+Entry* Keepass2DatabaseInterface::entryFromId(quint32 entryId)
 {
-    if (value == 0) {
-        return "0";
-    } else if (value == 0xfffffffe) {
-        return "fffffffe";
-    } else {
-        return QString(QByteArray::number(value, 16));
-    }
+    return (Entry*)m_itemHandles.value(entryId, DatabaseItemType::ENTRY);
 }
 
 void Keepass2DatabaseInterface::slot_changeKeyTransfRounds(int value)
 {
+    // do nothing if no database is opened database
+    if (!m_Database) return;
+    if (m_readOnly) {
+        emit errorOccured(DatabaseAccessResult::RE_DB_READ_ONLY, "");
+        return;
+    }
+
+    // negative value means calibrate the rounds for the given open time in milliseconds
+    if (value < 0) {
+        value = qMax(1, CompositeKey::transformKeyBenchmark(-value));
+    }
+    // the master key is transformed again with the new number of rounds
+    if (!m_Database->setTransformRounds(quint64(value))) {
+        emit errorOccured(DatabaseAccessResult::RE_DB_SETKEY_ERROR, "");
+        return;
+    }
+    emit databaseKeyTransfRoundsChanged(m_Database->transformRounds());
+    // schedule saving changes to database
+    scheduleSave();
+}
+
+void Keepass2DatabaseInterface::slot_calibrateKeyTransfRounds(int targetTime)
+{
+    // measure key transformation speed of this device with the benchmark of the keepassx library
+    int rounds = qMax(1, CompositeKey::transformKeyBenchmark(targetTime));
+    int openTime = -1;
+    if (m_Database) {
+        openTime = int(m_Database->transformRounds() * quint64(targetTime) / quint64(rounds));
+    }
+    emit keyTransfRoundsCalibrated(rounds, openTime);
 }
 
 void Keepass2DatabaseInterface::slot_changeCryptAlgorithm(int value)
 {
+    // do nothing if no database is opened database
+    if (!m_Database) return;
+    if (m_readOnly) {
+        emit errorOccured(DatabaseAccessResult::RE_DB_READ_ONLY, "");
+        return;
+    }
+
+    // set crypto algorithm in database and emit changed signal, numbering is the same as for Keepass 1
+    m_Database->setCipher(value == 1 ? KeePass2::CIPHER_TWOFISH : KeePass2::CIPHER_AES);
+    emit databaseCryptAlgorithmChanged(cryptAlgorithm(m_Database->cipher()));
+    // schedule saving changes to database
+    scheduleSave();
+}
+
+/*!
+\brief Get the algorithm number which is used in the UI for a Keepass 2 cipher
+
+The UI uses the numbering of Keepass 1, i.e. 0 for Rijndael (AES) and 1 for Twofish.
+*/
+int Keepass2DatabaseInterface::cryptAlgorithm(const Uuid& cipher)
+{
+    return cipher == KeePass2::CIPHER_TWOFISH ? 1 : 0;
+}
+
+/*!
+\brief Create the composite key of the master password and an optional key file
+
+\return false if the key file cannot be loaded, errorMsg contains the reason then
+*/
+bool Keepass2DatabaseInterface::buildMasterKey(const QString& password, const QString& keyfile,
+                                               CompositeKey& masterKey, QString& errorMsg)
+{
+    masterKey.addKey(PasswordKey(password));
+    if (!keyfile.isEmpty()) {
+        FileKey key;
+        if (!key.load(keyfile, &errorMsg)) {
+            return false;
+        }
+        masterKey.addKey(key);
+    }
+    return true;
 }
@@ -0,0 +1,118 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+#ifndef LISTMODELREGISTRY_H
+#define LISTMODELREGISTRY_H
+
+#include <QHash>
+#include <QSet>
+#include <QList>
+
+namespace kpxPrivate {
+
+/*!
+ * \brief The ListModelRegistry class stores which list models are showing a
+ * dedicated group or entry in the UI.
+ *
+ * It is indexed in both directions, so that the list models which need an
+ * update after a group or entry was changed are found without going through
+ * the items of all list models. Models and items are identified by their
+ * handles, see ItemHandleTable.
+ */
+class ListModelRegistry
+{
+public:
+    void registerItem(quint32 modelId, quint32 itemId)
+    {
+        m_modelItems[modelId].insert(itemId);
+        m_itemModels[itemId].insert(modelId);
+    }
+
+    //! Removes a list model and all its items from the registry
+    void unregisterModel(quint32 modelId)
+    {
+        QHash<quint32, QSet<quint32> >::iterator model = m_modelItems.find(modelId);
+        if (model == m_modelItems.end()) return;
+        QSet<quint32>::const_iterator it;
+        for (it = model.value().constBegin(); it != model.value().constEnd(); ++it) {
+            removeFrom(m_itemModels, *it, modelId);
+        }
+        m_modelItems.erase(model);
+    }
+
+    //! Removes an item from all list models, e.g. after it was deleted or moved
+    void unregisterItem(quint32 itemId)
+    {
+        QHash<quint32, QSet<quint32> >::iterator item = m_itemModels.find(itemId);
+        if (item == m_itemModels.end()) return;
+        QSet<quint32>::const_iterator it;
+        for (it = item.value().constBegin(); it != item.value().constEnd(); ++it) {
+            removeFrom(m_modelItems, *it, itemId);
+        }
+        m_itemModels.erase(item);
+    }
+
+    //! Removes an item from one list model only
+    void unregisterItem(quint32 modelId, quint32 itemId)
+    {
+        removeFrom(m_modelItems, modelId, itemId);
+        removeFrom(m_itemModels, itemId, modelId);
+    }
+
+    //! Returns the IDs of all list models which show the item
+    QList<quint32> models(quint32 itemId) const
+    {
+        return m_itemModels.value(itemId).toList();
+    }
+
+    //! Returns true if the list model shows at least one item
+    bool containsModel(quint32 modelId) const
+    {
+        return m_modelItems.contains(modelId);
+    }
+
+    void clear()
+    {
+        m_modelItems.clear();
+        m_itemModels.clear();
+    }
+
+private:
+    static void removeFrom(QHash<quint32, QSet<quint32> >& index, quint32 key, quint32 value)
+    {
+        QHash<quint32, QSet<quint32> >::iterator it = index.find(key);
+        if (it == index.end()) return;
+        it.value().remove(value);
+        if (it.value().isEmpty()) {
+            index.erase(it);
+        }
+    }
+
+    // model ID -> IDs of items shown in the model
+    QHash<quint32, QSet<quint32> > m_modelItems;
+    // item ID -> IDs of models showing the item
+    QHash<quint32, QSet<quint32> > m_itemModels;
+};
+
+}
+
+#endif // LISTMODELREGISTRY_H
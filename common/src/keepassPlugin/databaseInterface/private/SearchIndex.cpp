@@ -0,0 +1,189 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+#include <QPair>
+#include <QtAlgorithms>
+
+#include "SearchIndex.h"
+
+using namespace kpxPrivate;
+
+// Fields are separated by a newline in the stored text, grams containing it span two fields and are not indexed
+static const QChar FIELD_SEPARATOR('\n');
+
+quint64 SearchIndex::gram(const QChar* chars)
+{
+    return (quint64(chars[0].unicode()) << 32) | (quint64(chars[1].unicode()) << 16) | quint64(chars[2].unicode());
+}
+
+void SearchIndex::grams(const QString& text, QSet<quint64>& result)
+{
+    const QChar* chars = text.constData();
+    for (int i = 0; i + GRAM_SIZE <= text.length(); i++) {
+        if (chars[i] == FIELD_SEPARATOR || chars[i + 1] == FIELD_SEPARATOR || chars[i + 2] == FIELD_SEPARATOR) {
+            continue;
+        }
+        result.insert(gram(chars + i));
+    }
+}
+
+void SearchIndex::insert(quint32 itemId, const QStringList& fields)
+{
+    QString text = fields.join(FIELD_SEPARATOR).toCaseFolded();
+    Item item;
+    item.position = m_nextPosition;
+    QHash<quint32, Item>::const_iterator existing = m_items.constFind(itemId);
+    if (existing != m_items.constEnd()) {
+        if (existing.value().text == text) return;
+        // a changed entry keeps its place in the results
+        item.position = existing.value().position;
+        remove(itemId);
+    } else {
+        ++m_nextPosition;
+    }
+    item.text = text;
+    m_items.insert(itemId, item);
+
+    QSet<quint64> itemGrams;
+    grams(text, itemGrams);
+    QSet<quint64>::const_iterator it;
+    for (it = itemGrams.constBegin(); it != itemGrams.constEnd(); ++it) {
+        m_postings[*it].append(itemId);
+    }
+}
+
+void SearchIndex::remove(quint32 itemId)
+{
+    QHash<quint32, Item>::iterator item = m_items.find(itemId);
+    if (item == m_items.end()) return;
+
+    QSet<quint64> itemGrams;
+    grams(item.value().text, itemGrams);
+    QSet<quint64>::const_iterator it;
+    for (it = itemGrams.constBegin(); it != itemGrams.constEnd(); ++it) {
+        QHash<quint64, QVector<quint32> >::iterator posting = m_postings.find(*it);
+        if (posting == m_postings.end()) continue;
+        QVector<quint32>& items = posting.value();
+        int index = items.indexOf(itemId);
+        if (index >= 0) {
+            // order of the items in a posting does not matter
+            items[index] = items.last();
+            items.removeLast();
+        }
+        if (items.isEmpty()) {
+            m_postings.erase(posting);
+        }
+    }
+    m_items.erase(item);
+}
+
+void SearchIndex::clear()
+{
+    m_postings.clear();
+    m_items.clear();
+    m_nextPosition = 0;
+}
+
+bool SearchIndex::canSearch(const QStringList& words)
+{
+    for (int i = 0; i < words.count(); i++) {
+        if (words[i].length() >= GRAM_SIZE) return true;
+    }
+    return false;
+}
+
+QStringList SearchIndex::foldCase(const QStringList& words)
+{
+    QStringList foldedWords;
+    for (int i = 0; i < words.count(); i++) {
+        foldedWords << words[i].toCaseFolded();
+    }
+    return foldedWords;
+}
+
+bool SearchIndex::containsAll(quint32 itemId, const QVector<QStringMatcher>& matchers) const
+{
+    QHash<quint32, Item>::const_iterator item = m_items.constFind(itemId);
+    if (item == m_items.constEnd()) return false;
+    for (int i = 0; i < matchers.count(); i++) {
+        if (matchers[i].indexIn(item.value().text) == -1) return false;
+    }
+    return true;
+}
+
+QList<quint32> SearchIndex::filter(const QList<quint32>& itemIds, const QStringList& words) const
+{
+    QList<quint32> result;
+    // the stored texts are case folded already, so the words are folded once and compared case sensitive,
+    // each matcher keeps the skip table of its word for all candidates
+    QStringList foldedWords = foldCase(words);
+    QVector<QStringMatcher> matchers;
+    matchers.reserve(foldedWords.count());
+    for (int i = 0; i < foldedWords.count(); i++) {
+        matchers << QStringMatcher(foldedWords[i], Qt::CaseSensitive);
+    }
+    for (int i = 0; i < itemIds.count(); i++) {
+        if (containsAll(itemIds[i], matchers)) {
+            result << itemIds[i];
+        }
+    }
+    return result;
+}
+
+QList<quint32> SearchIndex::candidates(const QStringList& words) const
+{
+    if (!canSearch(words)) return inInsertionOrder(m_items.keys().toVector());
+
+    // the rarest gram of all words gives the smallest set of candidates
+    QStringList foldedWords = foldCase(words);
+    const QVector<quint32>* rarest = Q_NULLPTR;
+    for (int i = 0; i < foldedWords.count(); i++) {
+        const QString& word = foldedWords[i];
+        for (int j = 0; j + GRAM_SIZE <= word.length(); j++) {
+            QHash<quint64, QVector<quint32> >::const_iterator posting = m_postings.constFind(gram(word.constData() + j));
+            if (posting == m_postings.constEnd()) {
+                // no entry contains this part of the word
+                return QList<quint32>();
+            }
+            if (!rarest || posting.value().count() < rarest->count()) {
+                rarest = &posting.value();
+            }
+        }
+    }
+    return inInsertionOrder(*rarest);
+}
+
+QList<quint32> SearchIndex::inInsertionOrder(const QVector<quint32>& itemIds) const
+{
+    QVector<QPair<quint32, quint32> > positions;
+    positions.reserve(itemIds.count());
+    for (int i = 0; i < itemIds.count(); i++) {
+        positions << qMakePair(m_items.value(itemIds[i]).position, itemIds[i]);
+    }
+    qSort(positions);
+    QList<quint32> result;
+    result.reserve(positions.count());
+    for (int i = 0; i < positions.count(); i++) {
+        result << positions[i].second;
+    }
+    return result;
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QStringMatcher>
+#include <QVector>
+
+namespace kpxPrivate {
+
+/*!
+ * \brief The SearchIndex class is an inverted trigram index over the text
+ * fields of the entries of a database.
+ *
+ * For every sequence of three characters the index stores the entries which
+ * contain it in one of their fields. A search looks up the rarest trigram of
+ * the search term and checks only these entries, so it does not need to go
+ * through all entries of the database. Matching is case insensitive, the
+ * fields are stored case folded for checking the candidates.
+ *
+ * Entries are identified by their handle, see ItemHandleTable. The index
+ * must be updated whenever an entry is created, changed or deleted.
+ *
+ * Found entries are returned in the order in which they were inserted,
+ * i.e. in database order if the index is built from all entries of the
+ * database. Entries added later come last, a changed entry keeps its place.
+ */
+class SearchIndex
+{
+public:
+    SearchIndex() : m_nextPosition(0) {}
+
+    //! Number of characters of one gram, shorter search words cannot be looked up
+    static const int GRAM_SIZE = 3;
+
+    //! Adds an entry with the text of its searchable fields or replaces its fields
+    void insert(quint32 itemId, const QStringList& fields);
+    void remove(quint32 itemId);
+    void clear();
+
+    /*!
+     * \brief Returns true if at least one of the words is long enough to be
+     * looked up in the index. Otherwise the caller must search without it.
+     */
+    static bool canSearch(const QStringList& words);
+
+    /*!
+     * \brief Returns the entries which might contain all of the words, these
+     * must be checked with filter(). If none of the words is long enough to
+     * be looked up all entries are returned. This is used to search in
+     * chunks, see slot_searchEntries() of the database interfaces.
+     */
+    QList<quint32> candidates(const QStringList& words) const;
+
+    /*!
+     * \brief Returns the entries of itemIds which contain each of the words
+     * in at least one of their fields, words are matched case insensitive.
+     * This works for words of any length, e.g. to check the result of a
+     * previous search again. The order of the entries is kept.
+     */
+    QList<quint32> filter(const QList<quint32>& itemIds, const QStringList& words) const;
+
+private:
+    static void grams(const QString& text, QSet<quint64>& result);
+    static quint64 gram(const QChar* chars);
+    static QStringList foldCase(const QStringList& words);
+    bool containsAll(quint32 itemId, const QVector<QStringMatcher>& matchers) const;
+    QList<quint32> inInsertionOrder(const QVector<quint32>& itemIds) const;
+
+    struct Item
+    {
+        Item() : position(0) {}
+        // case folded fields, separated by newlines
+        QString text;
+        // order in which the entry was inserted first
+        quint32 position;
+    };
+
+    // gram -> entries containing it, in no particular order
+    QHash<quint64, QVector<quint32> > m_postings;
+    // entry -> its fields and position
+    QHash<quint32, Item> m_items;
+    quint32 m_nextPosition;
+};
+
+}
+
+#endif // SEARCHINDEX_H
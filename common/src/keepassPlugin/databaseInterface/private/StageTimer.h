@@ -0,0 +1,98 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+#ifndef STAGETIMER_H
+#define STAGETIMER_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+namespace kpxPrivate {
+
+/*!
+ * \brief The StageTimer class measures how long the stages of an operation
+ * like opening, saving or searching the database take.
+ *
+ * Each stage is recorded as a QVariantMap with the keys "name", "nsecs" and
+ * "bytes" (number of bytes processed, 0 if not applicable), so that the
+ * stages can be sent to QML with the stagesTimed() signal of the database
+ * interface. If the timer is disabled nothing is measured and all functions
+ * return right away.
+ */
+class StageTimer
+{
+public:
+    StageTimer() : m_enabled(false) {}
+
+    void setEnabled(bool value) { m_enabled = value; }
+    bool isEnabled() const { return m_enabled; }
+
+    //! Starts measuring a new operation, stages of the previous one are dropped
+    void start(const QString& operation)
+    {
+        if (!m_enabled) return;
+        m_operation = operation;
+        m_stages.clear();
+        m_clock.start();
+    }
+
+    //! Ends the current stage, the next stage starts right away
+    void endStage(const QString& name, qint64 bytes = 0)
+    {
+        if (!m_enabled) return;
+        addStage(name, m_clock.nsecsElapsed(), bytes);
+        m_clock.restart();
+    }
+
+    //! Adds a stage which was measured elsewhere, e.g. within the database library
+    void addStage(const QString& name, qint64 nsecs, qint64 bytes)
+    {
+        if (!m_enabled) return;
+        QVariantMap stage;
+        stage["name"] = name;
+        stage["nsecs"] = nsecs;
+        stage["bytes"] = bytes;
+        m_stages.append(stage);
+    }
+
+    const QString& operation() const { return m_operation; }
+
+    //! Returns the recorded stages and clears them
+    QVariantList takeStages()
+    {
+        QVariantList stages;
+        stages.swap(m_stages);
+        return stages;
+    }
+
+private:
+    bool m_enabled;
+    QString m_operation;
+    QVariantList m_stages;
+    QElapsedTimer m_clock;
+};
+
+}
+
+#endif // STAGETIMER_H
@@ -0,0 +1,244 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+#include "aes_hw.h"
+#include "aes_endian.h"
+
+/* The round keys are read directly from the key schedule of the Gladman */
+/* code. Its words are stored in platform byte order, which matches the  */
+/* byte order of the AES instructions only on little endian machines.    */
+
+#if PLATFORM_BYTE_ORDER == IS_LITTLE_ENDIAN
+
+/* The ARMv8 Crypto Extensions are enabled per function with the target */
+/* attribute, so they are also built if the whole build does not target */
+/* them, e.g. armv7hl. The intrinsics can be used this way since GCC 6  */
+/* on AArch64 and since GCC 8 on 32 bit ARM with a hardware FPU.        */
+
+#if defined( __GNUC__ ) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) ) && \
+    ( defined( __x86_64__ ) || defined( __i386__ ) )
+#  define AES_HW_X86
+#elif defined( __ARM_FEATURE_CRYPTO ) && defined( __linux__ ) && \
+    ( defined( __aarch64__ ) || defined( __arm__ ) )
+#  define AES_HW_ARM
+#  define AES_HW_ARM_TARGET
+#elif defined( __GNUC__ ) && !defined( __clang__ ) && __GNUC__ >= 6 && \
+    defined( __linux__ ) && defined( __aarch64__ )
+#  define AES_HW_ARM
+#  define AES_HW_ARM_TARGET __attribute__((target("+crypto")))
+#elif defined( __GNUC__ ) && !defined( __clang__ ) && __GNUC__ >= 8 && \
+    defined( __linux__ ) && defined( __arm__ ) && defined( __ARM_FP )
+#  define AES_HW_ARM
+#  define AES_HW_ARM_TARGET __attribute__((target("fpu=crypto-neon-fp-armv8")))
+#endif
+
+#endif
+
+#define AES_HW_NKEYS 15     /* number of round keys for AES-256 */
+
+/* cached result of the CPU feature detection: -1 not yet detected */
+static int aes_hw_detected = -1;
+
+#if defined( AES_HW_X86 )
+
+#include <cpuid.h>
+#include <wmmintrin.h>
+
+static int aes_hw_detect(void)
+{   unsigned int a, b, c, d;
+
+    if(!__get_cpuid(1, &a, &b, &c, &d))
+        return 0;
+    return (c & bit_AES) && (d & bit_SSE2) ? 1 : 0;
+}
+
+__attribute__((target("aes,sse2")))
+static void aes_hw_x86_encrypt_2x(const unsigned char *in, unsigned char *out,
+                    int rounds, const aes_encrypt_ctx cx[1])
+{   __m128i k[AES_HW_NKEYS], a, b;
+    int i;
+
+    for(i = 0; i < AES_HW_NKEYS; ++i)
+        k[i] = _mm_loadu_si128((const __m128i*)(cx->ks + 4 * i));
+
+    a = _mm_loadu_si128((const __m128i*)in);
+    b = _mm_loadu_si128((const __m128i*)(in + 16));
+
+    while(rounds--)
+    {
+        a = _mm_xor_si128(a, k[0]);
+        b = _mm_xor_si128(b, k[0]);
+        for(i = 1; i < AES_HW_NKEYS - 1; ++i)
+        {
+            a = _mm_aesenc_si128(a, k[i]);
+            b = _mm_aesenc_si128(b, k[i]);
+        }
+        a = _mm_aesenclast_si128(a, k[AES_HW_NKEYS - 1]);
+        b = _mm_aesenclast_si128(b, k[AES_HW_NKEYS - 1]);
+    }
+
+    _mm_storeu_si128((__m128i*)out, a);
+    _mm_storeu_si128((__m128i*)(out + 16), b);
+
+    /* do not leave round keys on the stack */
+    for(i = 0; i < AES_HW_NKEYS; ++i)
+        k[i] = _mm_setzero_si128();
+    __asm__ __volatile__("" : : "r"(k) : "memory");
+}
+
+#elif defined( AES_HW_ARM )
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+
+#if defined( __aarch64__ )
+#  ifndef HWCAP_AES
+#    define HWCAP_AES (1 << 3)
+#  endif
+#  define AES_HW_AUXV   AT_HWCAP
+#  define AES_HW_HWCAP  HWCAP_AES
+#else
+#  ifndef HWCAP2_AES
+#    define HWCAP2_AES (1 << 0)
+#  endif
+#  define AES_HW_AUXV   AT_HWCAP2
+#  define AES_HW_HWCAP  HWCAP2_AES
+#endif
+
+static int aes_hw_detect(void)
+{
+    return (getauxval(AES_HW_AUXV) & AES_HW_HWCAP) ? 1 : 0;
+}
+
+AES_HW_ARM_TARGET
+static void aes_hw_arm_encrypt_2x(const unsigned char *in, unsigned char *out,
+                    int rounds, const aes_encrypt_ctx cx[1])
+{   uint8x16_t k[AES_HW_NKEYS], a, b;
+    int i;
+
+    for(i = 0; i < AES_HW_NKEYS; ++i)
+        k[i] = vld1q_u8((const uint8_t*)(cx->ks + 4 * i));
+
+    a = vld1q_u8(in);
+    b = vld1q_u8(in + 16);
+
+    /* AESE includes AddRoundKey before SubBytes and ShiftRows, so the */
+    /* last round key is added with a separate XOR                     */
+    while(rounds--)
+    {
+        for(i = 0; i < AES_HW_NKEYS - 2; ++i)
+        {
+            a = vaesmcq_u8(vaeseq_u8(a, k[i]));
+            b = vaesmcq_u8(vaeseq_u8(b, k[i]));
+        }
+        a = veorq_u8(vaeseq_u8(a, k[AES_HW_NKEYS - 2]), k[AES_HW_NKEYS - 1]);
+        b = veorq_u8(vaeseq_u8(b, k[AES_HW_NKEYS - 2]), k[AES_HW_NKEYS - 1]);
+    }
+
+    vst1q_u8(out, a);
+    vst1q_u8(out + 16, b);
+
+    /* do not leave round keys on the stack */
+    for(i = 0; i < AES_HW_NKEYS; ++i)
+        k[i] = vdupq_n_u8(0);
+    __asm__ __volatile__("" : : "r"(k) : "memory");
+}
+
+#else
+
+static int aes_hw_detect(void)
+{
+    return 0;
+}
+
+#endif
+
+void aes_hw_ecb_encrypt_2x(const unsigned char *in, unsigned char *out,
+                    int rounds, const aes_encrypt_ctx cx[1])
+{
+#if defined( AES_HW_X86 )
+    aes_hw_x86_encrypt_2x(in, out, rounds, cx);
+#elif defined( AES_HW_ARM )
+    aes_hw_arm_encrypt_2x(in, out, rounds, cx);
+#else
+    (void)in; (void)out; (void)rounds; (void)cx;
+#endif
+}
+
+/* Checks the hardware code once against the AES-256 test vector of     */
+/* FIPS-197 (appendix C.3) and against the portable code for more than  */
+/* one round. If the results differ the portable code is used instead.  */
+static int aes_hw_self_test(void)
+{   static const unsigned char key[32] =
+    {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+        0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+        0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+    };
+    static const unsigned char plain[16] =
+    {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+    };
+    static const unsigned char cipher[16] =
+    {
+        0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+        0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89
+    };
+    aes_encrypt_ctx cx[1];
+    unsigned char in[32], out[32], ref[32];
+    int i, ok = 1;
+
+    aes_init();
+    aes_encrypt_key256(key, cx);
+
+    for(i = 0; i < 16; ++i)
+        in[i] = in[i + 16] = plain[i];
+    aes_hw_ecb_encrypt_2x(in, out, 1, cx);
+    for(i = 0; i < 16; ++i)
+        if(out[i] != cipher[i] || out[i + 16] != cipher[i])
+            ok = 0;
+
+    /* two different blocks and several rounds */
+    for(i = 0; i < 16; ++i)
+        in[i + 16] = cipher[i];
+    aes_hw_ecb_encrypt_2x(in, out, 3, cx);
+    for(i = 0; i < 32; i += 16)
+    {
+        aes_encrypt(in + i, ref + i, cx);
+        aes_encrypt(ref + i, ref + i, cx);
+        aes_encrypt(ref + i, ref + i, cx);
+    }
+    for(i = 0; i < 32; ++i)
+        if(out[i] != ref[i])
+            ok = 0;
+
+    return ok;
+}
+
+int aes_hw_available(void)
+{
+    if(aes_hw_detected < 0)
+        aes_hw_detected = aes_hw_detect() && aes_hw_self_test() ? 1 : 0;
+    return aes_hw_detected;
+}
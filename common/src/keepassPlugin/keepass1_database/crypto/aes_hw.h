@@ -0,0 +1,59 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+/*
+ Hardware accelerated AES-256 encryption for the master key transformation.
+
+ The AES instructions of the CPU (AES-NI on x86, Crypto Extensions on ARMv8)
+ are used if the CPU supports them. This is detected at runtime, so callers
+ must check aes_hw_available() and fall back to the portable code of
+ aescrypt.c otherwise. The round keys are taken from an encryption context
+ which was set up with aes_encrypt_key256().
+*/
+
+#ifndef _AES_HW_H
+#define _AES_HW_H
+
+#include "aes.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+/* Returns non-zero if hardware AES instructions can be used on this CPU. */
+/* On the first call the hardware code is checked with a known answer    */
+/* test, it is not used if the result is wrong.                         */
+int aes_hw_available(void);
+
+/* Encrypts two 16 byte blocks (in[0..31]) "rounds" times in ECB mode.  */
+/* Both blocks are processed interleaved in one loop in order to keep   */
+/* the pipelined AES unit of the CPU busy. in and out may be identical. */
+/* Must only be called if aes_hw_available() returned non-zero.         */
+void aes_hw_ecb_encrypt_2x(const unsigned char *in, unsigned char *out,
+                    int rounds, const aes_encrypt_ctx cx[1]);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -20,6 +20,7 @@
 
 #include <string.h>
 #include "sha256.h"
+#include "sha256_hw.h"
 
 #define GET_qquint32(n,b,i)                       \
 {                                               \
@@ -204,6 +205,21 @@ void sha256_process( sha256_context *ctx, const quint8 data[64] )
     ctx->state[7] += H;
 }
 
+static void sha256_process_blocks( sha256_context *ctx, const quint8 *data, quint32 blocks )
+{
+    if( sha256_hw_available() )
+    {
+        sha256_hw_process( ctx->state, data, blocks );
+        return;
+    }
+
+    while( blocks-- )
+    {
+        sha256_process( ctx, data );
+        data += 64;
+    }
+}
+
 void sha256_update( sha256_context *ctx, const quint8 *input, quint32 length )
 {
     quint32 left, fill;
@@ -223,17 +239,17 @@ void sha256_update( sha256_context *ctx, const quint8 *input, quint32 length )
     {
         memcpy( (void *) (ctx->buffer + left),
                 (void *) input, fill );
-        sha256_process( ctx, ctx->buffer );
+        sha256_process_blocks( ctx, ctx->buffer, 1 );
         length -= fill;
         input  += fill;
         left = 0;
     }
 
-    while( length >= 64 )
+    if( length >= 64 )
     {
-        sha256_process( ctx, input );
-        length -= 64;
-        input  += 64;
+        sha256_process_blocks( ctx, input, length / 64 );
+        input  += length & ~0x3F;
+        length &= 0x3F;
     }
 
     if( length )
@@ -0,0 +1,316 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+#include "sha256_hw.h"
+
+/* The ARMv8 Crypto Extensions are enabled per function with the target */
+/* attribute like in aes_hw.c, so the code is also built for armv7hl    */
+/* and aarch64 builds that do not target them as a whole.               */
+
+#if defined( __GNUC__ ) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) ) && \
+    ( defined( __x86_64__ ) || defined( __i386__ ) )
+#  define SHA256_HW_X86
+#elif defined( __ARM_FEATURE_CRYPTO ) && defined( __linux__ ) && \
+    ( defined( __aarch64__ ) || defined( __arm__ ) )
+#  define SHA256_HW_ARM
+#  define SHA256_HW_ARM_TARGET
+#elif defined( __GNUC__ ) && !defined( __clang__ ) && __GNUC__ >= 6 && \
+    defined( __linux__ ) && defined( __aarch64__ )
+#  define SHA256_HW_ARM
+#  define SHA256_HW_ARM_TARGET __attribute__((target("+crypto")))
+#elif defined( __GNUC__ ) && !defined( __clang__ ) && __GNUC__ >= 8 && \
+    defined( __linux__ ) && defined( __arm__ ) && defined( __ARM_FP )
+#  define SHA256_HW_ARM
+#  define SHA256_HW_ARM_TARGET __attribute__((target("fpu=crypto-neon-fp-armv8")))
+#endif
+
+/* cached result of the CPU feature detection: -1 not yet detected */
+static int sha256_hw_detected = -1;
+
+#if defined( SHA256_HW_X86 ) || defined( SHA256_HW_ARM )
+
+static const uint32_t sha256_hw_k[64] =
+{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+    0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+    0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+    0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+    0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+    0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+#endif
+
+#if defined( SHA256_HW_X86 )
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#ifndef bit_SHA
+#  define bit_SHA (1 << 29)
+#endif
+
+static int sha256_hw_detect(void)
+{   unsigned int a, b, c, d;
+
+    if(__get_cpuid_max(0, 0) < 7)
+        return 0;
+    __cpuid(1, a, b, c, d);
+    if(!(c & bit_SSSE3) || !(c & bit_SSE4_1))
+        return 0;
+    __cpuid_count(7, 0, a, b, c, d);
+    return (b & bit_SHA) ? 1 : 0;
+}
+
+/* The SHA instructions work on the state in the order ABEF and CDGH */
+
+#define SHA256_HW_LOAD_STATE(st, s0, s1)                                \
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(st)), 0xB1); \
+    s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(st + 4)), 0x1B); \
+    s0 = _mm_alignr_epi8(tmp, s1, 8);                                   \
+    s1 = _mm_blend_epi16(s1, tmp, 0xF0)
+
+#define SHA256_HW_STORE_STATE(st, s0, s1)                               \
+    tmp = _mm_shuffle_epi32(s0, 0x1B);                                  \
+    s1 = _mm_shuffle_epi32(s1, 0xB1);                                   \
+    _mm_storeu_si128((__m128i*)(st), _mm_blend_epi16(tmp, s1, 0xF0));   \
+    _mm_storeu_si128((__m128i*)(st + 4), _mm_alignr_epi8(s1, tmp, 8))
+
+#define SHA256_HW_LOAD_MSG(m, d)                                        \
+    m = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(d)), mask)
+
+/* four rounds with the message words m and the constants k */
+#define SHA256_HW_QROUND(s0, s1, m, k)                                  \
+    tmp = _mm_add_epi32(m, _mm_loadu_si128((const __m128i*)(k)));       \
+    s1 = _mm_sha256rnds2_epu32(s1, s0, tmp);                            \
+    tmp = _mm_shuffle_epi32(tmp, 0x0E);                                 \
+    s0 = _mm_sha256rnds2_epu32(s0, s1, tmp)
+
+/* m0 gets the next four message words from the previous sixteen m0..m3 */
+#define SHA256_HW_SCHED(m0, m1, m2, m3)                                 \
+    m0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m0, m1), \
+                    _mm_alignr_epi8(m3, m2, 4)), m3)
+
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256_hw_x86_process(uint32_t state[8], const unsigned char *data,
+                    unsigned long blocks)
+{   const __m128i mask = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+    __m128i s0, s1, a0, a1, m0, m1, m2, m3, tmp;
+    int i;
+
+    SHA256_HW_LOAD_STATE(state, s0, s1);
+
+    while(blocks--)
+    {
+        a0 = s0;
+        a1 = s1;
+
+        SHA256_HW_LOAD_MSG(m0, data);
+        SHA256_HW_LOAD_MSG(m1, data + 16);
+        SHA256_HW_LOAD_MSG(m2, data + 32);
+        SHA256_HW_LOAD_MSG(m3, data + 48);
+
+        SHA256_HW_QROUND(s0, s1, m0, sha256_hw_k);
+        SHA256_HW_QROUND(s0, s1, m1, sha256_hw_k + 4);
+        SHA256_HW_QROUND(s0, s1, m2, sha256_hw_k + 8);
+        SHA256_HW_QROUND(s0, s1, m3, sha256_hw_k + 12);
+        for(i = 16; i < 64; i += 16)
+        {
+            SHA256_HW_SCHED(m0, m1, m2, m3);
+            SHA256_HW_QROUND(s0, s1, m0, sha256_hw_k + i);
+            SHA256_HW_SCHED(m1, m2, m3, m0);
+            SHA256_HW_QROUND(s0, s1, m1, sha256_hw_k + i + 4);
+            SHA256_HW_SCHED(m2, m3, m0, m1);
+            SHA256_HW_QROUND(s0, s1, m2, sha256_hw_k + i + 8);
+            SHA256_HW_SCHED(m3, m0, m1, m2);
+            SHA256_HW_QROUND(s0, s1, m3, sha256_hw_k + i + 12);
+        }
+
+        s0 = _mm_add_epi32(s0, a0);
+        s1 = _mm_add_epi32(s1, a1);
+        data += 64;
+    }
+
+    SHA256_HW_STORE_STATE(state, s0, s1);
+}
+
+#elif defined( SHA256_HW_ARM )
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+
+#if defined( __aarch64__ )
+#  ifndef HWCAP_SHA2
+#    define HWCAP_SHA2 (1 << 6)
+#  endif
+#  define SHA256_HW_AUXV   AT_HWCAP
+#  define SHA256_HW_HWCAP  HWCAP_SHA2
+#else
+#  ifndef HWCAP2_SHA2
+#    define HWCAP2_SHA2 (1 << 3)
+#  endif
+#  define SHA256_HW_AUXV   AT_HWCAP2
+#  define SHA256_HW_HWCAP  HWCAP2_SHA2
+#endif
+
+static int sha256_hw_detect(void)
+{
+    return (getauxval(SHA256_HW_AUXV) & SHA256_HW_HWCAP) ? 1 : 0;
+}
+
+/* four rounds with the message words m and the constants k */
+#define SHA256_HW_QROUND(m, k)                                          \
+    tmp = vaddq_u32(m, vld1q_u32(k));                                   \
+    abcd = s0;                                                          \
+    s0 = vsha256hq_u32(s0, s1, tmp);                                    \
+    s1 = vsha256h2q_u32(s1, abcd, tmp)
+
+/* m0 gets the next four message words from the previous sixteen m0..m3 */
+#define SHA256_HW_SCHED(m0, m1, m2, m3)                                 \
+    m0 = vsha256su1q_u32(vsha256su0q_u32(m0, m1), m2, m3)
+
+SHA256_HW_ARM_TARGET
+static void sha256_hw_arm_process(uint32_t state[8], const unsigned char *data,
+                    unsigned long blocks)
+{   uint32x4_t s0, s1, a0, a1, m0, m1, m2, m3, abcd, tmp;
+    int i;
+
+    s0 = vld1q_u32(state);
+    s1 = vld1q_u32(state + 4);
+
+    while(blocks--)
+    {
+        a0 = s0;
+        a1 = s1;
+
+        m0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+        m1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16)));
+        m2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 32)));
+        m3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 48)));
+
+        SHA256_HW_QROUND(m0, sha256_hw_k);
+        SHA256_HW_QROUND(m1, sha256_hw_k + 4);
+        SHA256_HW_QROUND(m2, sha256_hw_k + 8);
+        SHA256_HW_QROUND(m3, sha256_hw_k + 12);
+        for(i = 16; i < 64; i += 16)
+        {
+            SHA256_HW_SCHED(m0, m1, m2, m3);
+            SHA256_HW_QROUND(m0, sha256_hw_k + i);
+            SHA256_HW_SCHED(m1, m2, m3, m0);
+            SHA256_HW_QROUND(m1, sha256_hw_k + i + 4);
+            SHA256_HW_SCHED(m2, m3, m0, m1);
+            SHA256_HW_QROUND(m2, sha256_hw_k + i + 8);
+            SHA256_HW_SCHED(m3, m0, m1, m2);
+            SHA256_HW_QROUND(m3, sha256_hw_k + i + 12);
+        }
+
+        s0 = vaddq_u32(s0, a0);
+        s1 = vaddq_u32(s1, a1);
+        data += 64;
+    }
+
+    vst1q_u32(state, s0);
+    vst1q_u32(state + 4, s1);
+}
+
+#else
+
+static int sha256_hw_detect(void)
+{
+    return 0;
+}
+
+#endif
+
+
+void sha256_hw_process(uint32_t state[8], const unsigned char *data,
+                    unsigned long blocks)
+{
+#if defined( SHA256_HW_X86 )
+    sha256_hw_x86_process(state, data, blocks);
+#elif defined( SHA256_HW_ARM )
+    sha256_hw_arm_process(state, data, blocks);
+#else
+    (void)state; (void)data; (void)blocks;
+#endif
+}
+
+/* Checks the hardware code once against the SHA-256 test vectors of    */
+/* FIPS 180-2 for "abc" and the empty message. If the results differ   */
+/* the portable code of sha256.cpp is used instead.                     */
+static int sha256_hw_self_test(void)
+{   static const uint32_t init[8] =
+    {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+        0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+    };
+    static const uint32_t abc[8] =
+    {
+        0xBA7816BF, 0x8F01CFEA, 0x414140DE, 0x5DAE2223,
+        0xB00361A3, 0x96177A9C, 0xB410FF61, 0xF20015AD
+    };
+    static const uint32_t empty[8] =
+    {
+        0xE3B0C442, 0x98FC1C14, 0x9AFBF4C8, 0x996FB924,
+        0x27AE41E4, 0x649B934C, 0xA495991B, 0x7852B855
+    };
+    unsigned char block0[64], block1[64];
+    uint32_t state0[8], state1[8];
+    int i, ok = 1;
+
+    /* the padded messages, the length is given in bits */
+    for(i = 0; i < 64; ++i)
+        block0[i] = block1[i] = 0;
+    block0[0] = 'a';
+    block0[1] = 'b';
+    block0[2] = 'c';
+    block0[3] = 0x80;
+    block0[63] = 24;
+    block1[0] = 0x80;
+
+    for(i = 0; i < 8; ++i)
+        state0[i] = state1[i] = init[i];
+    sha256_hw_process(state0, block0, 1);
+    sha256_hw_process(state1, block1, 1);
+    for(i = 0; i < 8; ++i)
+        if(state0[i] != abc[i] || state1[i] != empty[i])
+            ok = 0;
+
+    return ok;
+}
+
+int sha256_hw_available(void)
+{
+    if(sha256_hw_detected < 0)
+        sha256_hw_detected = sha256_hw_detect() && sha256_hw_self_test() ? 1 : 0;
+    return sha256_hw_detected;
+}
@@ -0,0 +1,56 @@
+/***************************************************************************
+**
+** Copyright (C) 2015 Marko Koschak (marko.koschak@tisno.de)
+** All rights reserved.
+**
+** This file is part of ownKeepass.
+**
+** ownKeepass is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** ownKeepass is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with ownKeepass.  If not, see <http://www.gnu.org/licenses/>.
+**
+***************************************************************************/
+
+/*
+ Hardware accelerated SHA-256 compression function.
+
+ The SHA instructions of the CPU (SHA extensions on x86, Crypto Extensions
+ on ARMv8) are used if the CPU supports them. This is detected at runtime,
+ so callers must check sha256_hw_available() and fall back to the portable
+ code of sha256.cpp otherwise. The state is the one of sha256_context.
+*/
+
+#ifndef _SHA256_HW_H
+#define _SHA256_HW_H
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+/* Returns non-zero if hardware SHA-256 instructions can be used on this CPU. */
+/* On the first call the hardware code is checked with a known answer       */
+/* test, it is not used if the result is wrong.                            */
+int sha256_hw_available(void);
+
+/* Runs the compression function over "blocks" 64 byte blocks of data.  */
+/* Must only be called if sha256_hw_available() returned non-zero.      */
+void sha256_hw_process(uint32_t state[8], const unsigned char *data,
+                    unsigned long blocks);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
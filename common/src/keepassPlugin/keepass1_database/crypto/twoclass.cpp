@@ -137,3 +137,30 @@ int CTwofish::padDecrypt(quint8 *pInput, int nInputOctets, quint8 *pOutBuffer)
 
 	return 16*numBlocks - padLen;
 }
+
+int CTwofish::cbcDecrypt(quint8 *pInput, int nInputOctets, quint8 *pOutBuffer)
+{
+	int i, numBlocks;
+	quint8 block[16];
+
+	if((pInput == NULL) || (nInputOctets <= 0) || (pOutBuffer == NULL)) return 0;
+
+	if((nInputOctets % 16) != 0) return -1;
+
+	numBlocks = nInputOctets / 16;
+
+	for(i = 0; i < numBlocks; i++)
+	{
+		Twofish_decrypt(&m_key, (Twofish_Byte *)pInput, (Twofish_Byte *)block);
+		((quint32*)block)[0] ^= ((quint32*)m_pInitVector)[0];
+		((quint32*)block)[1] ^= ((quint32*)m_pInitVector)[1];
+		((quint32*)block)[2] ^= ((quint32*)m_pInitVector)[2];
+		((quint32*)block)[3] ^= ((quint32*)m_pInitVector)[3];
+		memcpy(m_pInitVector, pInput, 16);
+		memcpy(pOutBuffer, block, 16);
+		pInput += 16;
+		pOutBuffer += 16;
+	}
+
+	return nInputOctets;
+}
@@ -33,6 +33,9 @@ public:
 
 	int padEncrypt(quint8 *pInput, int nInputOctets, quint8 *pOutBuffer);
 	int padDecrypt(quint8 *pInput, int nInputOctets, quint8 *pOutBuffer);
+	// Decrypts whole blocks in CBC mode without removing the padding. The IV
+	// is updated, so consecutive calls continue to decrypt the same stream.
+	int cbcDecrypt(quint8 *pInput, int nInputOctets, quint8 *pOutBuffer);
 
 private:
 	Twofish_key m_key;
@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include <QCoreApplication>
+#include <QHash>
 #include <QLocale>
 #include "crypto/yarrow.h"
 #include "Database_keepassx1.h"
@@ -30,6 +31,10 @@ KpxUuid::KpxUuid(const void* src){
 	fromRaw(src);
 }
 
+uint qHash(const KpxUuid& uuid, uint seed){
+	return qHash(QByteArray::fromRawData((const char*)uuid.data(),16),seed);
+}
+
 void KpxUuid::generate(){
 	char uuid[16];
 	randomize(uuid,16);
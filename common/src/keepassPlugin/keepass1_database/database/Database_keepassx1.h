@@ -53,6 +53,9 @@ private:
 	QByteArray Data;
 };
 
+//! Hash function for using KpxUuid as key of a QHash.
+uint qHash(const KpxUuid& uuid, uint seed = 0);
+
 //! Advanced DateTime Class.
 /*!
 This class advances the standard Qt class 'QDateTime' with KeePassX specific methods for string conversion.
@@ -232,6 +235,9 @@ public:
 	virtual bool expanded()=0;
 	virtual void setExpanded(bool)=0;
 
+	//! \return the number of entries in the group without the entries of its subgroups.
+	virtual int numEntries()=0;
+
 };
 
 //! Common Database Interface.
@@ -395,16 +401,6 @@ public:
 	/*! \return the number of built-in icons of the database. Each database must contain at least one built-in icon. */
 	virtual int builtinIcons()=0;
 
-	/*! Searches in the database for a string or regular expression.
-		\param Group The group where the search should be performed in. If Group is NULL the search will be performed in the whole database.
-		\param SearchString The searched string or a regular expression.
-		\param CaseSensitvie If this parameter is true the search will be case sensitive.
-		\param RegExp The SearchString parameter will be handled as regular expression if this parameter is true.
-		\param Recursive Defines whether the search should include subgroups of Group or not. This parameter has no effect if Group is NULL.
-		\param Fields A pointer to a six element bool array. It defines which fields are included into the search. The order is: title, username, url, password, comment, attachment description. The pointer can also be NULL, than the default pattern is used instead.
-		\return the search results as a list of pointers to the entry handles.*/
-	virtual QList<IEntryHandle*> search(IGroupHandle* Group,const QString& SearchString, bool CaseSensitve, bool RegExp,bool Recursive,bool* Fields)=0;
-	
 	//virtual IDatabase* groupToNewDb(IGroupHandle* group)=0;
 };
 
@@ -20,7 +20,19 @@
 #include <QDebug>
 
 #include <QBuffer>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QMutex>
+#include <QQueue>
+#include <QVector>
+#include <QSemaphore>
+#include <QSet>
+#include <QWaitCondition>
 #include <algorithm>
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include "Kdb3Database.h"
 #include "config/KpxConfig.h"
@@ -30,6 +42,7 @@
 #include "crypto/yarrow.h"
 #include "crypto/sha256.h"
 #include "crypto/aescpp.h"
+#include "crypto/aes_hw.h"
 
 #define UNEXP_ERROR error=QString("Unexpected error in: %1, Line:%2").arg(__FILE__).arg(__LINE__);
 
@@ -42,31 +55,38 @@ bool Kdb3Database::EntryHandleLessThan(const IEntryHandle* This,const IEntryHand
 	return This->visualIndex()<Other->visualIndex();
 }
 
-bool Kdb3Database::EntryHandleLessThanStd(const IEntryHandle* This,const IEntryHandle* Other){
-    int comp = This->title().toLower().compare(Other->title().toLower());
-	if (comp < 0) return true;
-	else if (comp > 0) return false;
-	
-    comp = This->username().toLower().compare(Other->username().toLower());
-	if (comp < 0) return true;
-	else if (comp > 0) return false;
-	
-    return true;
+//! Sorts entries by title and then by username, the sort keys need to be computed already.
+bool Kdb3Database::StdEntrySortKeyLessThan(const Kdb3Database::StdEntry* This,const Kdb3Database::StdEntry* Other){
+	return This->SortKey<Other->SortKey;
 }
 
-bool Kdb3Database::GroupHandleLessThanStd(const IGroupHandle* This,const IGroupHandle* Other){
-    int comp = This->title().toLower().compare(Other->title().toLower());
-    if (comp > 0) return false;
-    else return true;
+//! Sorts groups by title, the sort keys need to be computed already.
+bool Kdb3Database::StdGroupSortKeyLessThan(const Kdb3Database::StdGroup* This,const Kdb3Database::StdGroup* Other){
+	return This->SortKey<Other->SortKey;
 }
 
-bool Kdb3Database::StdEntryLessThan(const Kdb3Database::StdEntry& This,const Kdb3Database::StdEntry& Other){
-	return This.Index<Other.Index;
+bool Kdb3Database::StdEntryLessThan(const Kdb3Database::StdEntry* This,const Kdb3Database::StdEntry* Other){
+	return This->Index<Other->Index;
+}
+
+
+Kdb3Database::Kdb3Database() : File(NULL), openedReadOnly(false), RawMasterKey(32), RawMasterKey_CP1252(32),
+	RawMasterKey_Latin1(32), RawMasterKey_UTF8(32), MasterKey(32), SpeculativeDecryption(true), StageTiming(false){
 }
 
+void Kdb3Database::beginStages(){
+	if(!StageTiming)
+		return;
+	Stages.clear();
+	StageClock.start();
+}
 
-Kdb3Database::Kdb3Database() : File(NULL), RawMasterKey(32), RawMasterKey_CP1252(32),
-	RawMasterKey_Latin1(32), RawMasterKey_UTF8(32), MasterKey(32){
+void Kdb3Database::endStage(const char* Name, qint64 Bytes){
+	if(!StageTiming)
+		return;
+	Stage stage = {Name, StageClock.nsecsElapsed(), Bytes};
+	Stages << stage;
+	StageClock.restart();
 }
 
 QString Kdb3Database::getError(){
@@ -92,10 +112,14 @@ void Kdb3Database::removeIcon(int id){
 	if(id >= CustomIcons.size()) return;
 	CustomIcons.removeAt(id); // .isNull()==true
 	for(int i=0;i<Entries.size();i++){
-		if(Entries[i].Image == id+builtinIcons())
+		if(Entries[i].Image == id+builtinIcons()){
 			Entries[i].Image=0;
-		if(Entries[i].Image>id+builtinIcons())
+			Entries[i].invalidateRecord();
+		}
+		if(Entries[i].Image>id+builtinIcons()){
 			Entries[i].Image--;
+			Entries[i].invalidateRecord();
+		}
 	}
 	for(int i=0;i<Groups.size();i++){
 		if(Groups[i].Image == id+builtinIcons())
@@ -317,15 +341,18 @@ void Kdb3Database::createGroupTreeStateMetaStream(StdEntry* e){
 }
 
 Kdb3Database::StdEntry* Kdb3Database::getEntry(const KpxUuid& uuid){
-	for(int i=0; i<Entries.size();i++)
-		if(Entries[i].Uuid==uuid)return &Entries[i];
-	return NULL;
+	return EntriesByUuid.value(uuid,NULL);
 }
 
 Kdb3Database::StdGroup* Kdb3Database::getGroup(quint32 Id){
-	for(int i=0; i<Groups.size();i++)
-		if(Groups[i].Id==Id)return &Groups[i];
-	return NULL;
+	return GroupsById.value(Id,NULL);
+}
+
+void Kdb3Database::removeFromEntryIndex(StdEntry* entry){
+	// entries of damaged files might share an UUID, only the first of them is in the index
+	QHash<KpxUuid,StdEntry*>::iterator it=EntriesByUuid.find(entry->Uuid);
+	if(it!=EntriesByUuid.end() && it.value()==entry)
+		EntriesByUuid.erase(it);
 }
 
 
@@ -436,53 +463,47 @@ bool Kdb3Database::readGroupField(StdGroup* group,QList<quint32>& Levels,quint16
 bool Kdb3Database::createGroupTree(QList<quint32>& Levels){
 	if(Levels[0]!=0) return false;
 	//find the parent for every group
+	//Ancestors holds the indices of the groups on the path to the previous group, the first item
+	//with a lower level than the current group is the last one in it with a lower level
+	QVector<int> Ancestors;
+	GroupsById.clear();
+	GroupsById.reserve(Groups.size());
 	for(int i=0;i<Groups.size();i++){
+		if(!GroupsById.contains(Groups[i].Id))
+			GroupsById.insert(Groups[i].Id,&Groups[i]);
+		while(!Ancestors.isEmpty() && Levels[Ancestors.last()]>=Levels[i])
+			Ancestors.pop_back();
 		if(Levels[i]==0){
 			Groups[i].Parent=&RootGroup;
 			Groups[i].Index=RootGroup.Children.size();
 			RootGroup.Children.append(&Groups[i]);
+			Ancestors.append(i);
 			continue;
 		}
-		int j;
-		//the first item with a lower level is the parent
-		for(j=i-1;j>=0;j--){
-			if(Levels[j]<Levels[i]){
-				if(Levels[i]-Levels[j]!=1)return false;
-				break;
-			}
-			if(j==0)return false; //No parent found
-		}
+		if(Ancestors.isEmpty())return false; //No parent found
+		int j=Ancestors.last();
+		if(Levels[i]-Levels[j]!=1)return false;
 		Groups[i].Parent=&Groups[j];
 		Groups[i].Index=Groups[j].Children.size();
 		Groups[i].Parent->Children.append(&Groups[i]);
+		Ancestors.append(i);
 	}
 
-	QList<int> EntryIndexCounter;
-	for(int i=0;i<Groups.size();i++)EntryIndexCounter << 0;
-
+	EntriesByUuid.clear();
+	EntriesByUuid.reserve(Entries.size());
 	for(int e=0;e<Entries.size();e++){
-		int groupIndex = -1;
-		for(int g=0;g<Groups.size();g++){
-			if(Entries[e].GroupId==Groups[g].Id){
-				groupIndex = g;
-				break;
-			}
-		}
-		
-		if (groupIndex == -1) {
+		if(!EntriesByUuid.contains(Entries[e].Uuid))
+			EntriesByUuid.insert(Entries[e].Uuid,&Entries[e]);
+
+		StdGroup* Group=getGroup(Entries[e].GroupId);
+		if (!Group) {
 			qWarning("Orphaned entry found, assigning to first group");
-			for(int g=0;g<Groups.size();g++){
-				if(Groups[g].Id == RootGroup.Children[0]->Id){
-					groupIndex = g;
-					break;
-				}
-			}
+			Group=RootGroup.Children[0];
 		}
 		
-		Groups[groupIndex].Entries.append(&Entries[e]);
-		Entries[e].Group=&Groups[groupIndex];
-		Entries[e].Index=EntryIndexCounter[groupIndex];
-		EntryIndexCounter[groupIndex]++;
+		// the entry lists of the groups are filled after the meta streams have been removed
+		Entries[e].Group=Group;
+		Entries[e].GroupId=Group->Id;
 	}
 
 	return true;
@@ -522,16 +543,314 @@ void Kdb3Database::restoreGroupTreeState(){
 }
 
 bool Kdb3Database::load(QString identifier, bool readOnly){
-	return loadReal(identifier, readOnly, false);
+	return loadReal(identifier, readOnly);
+}
+
+//! Size of the chunks in which the database content is read, decrypted and hashed.
+static const int ContentChunkSize = 256*1024;
+
+//! Decryption and content hash state for one master key which is tried on the database content.
+struct Kdb3Database::DecryptCandidate{
+	enum{Pending, Success, InitError, SizeError, HashError};
+	
+	DecryptCandidate() : CryptoSize(0), Result(Pending) {}
+	~DecryptCandidate(){
+		SecString::overwrite(MasterKey,32);
+		SecString::overwrite(IV,16);
+		Plain.fill(0);
+	}
+	
+	void init(CryptAlgorithm algorithm, quint8* FinalRandomSeed, quint8* EncryptionIV){
+		quint8 FinalKey[32];
+		SHA256 sha;
+		sha.update(FinalRandomSeed,16);
+		sha.update(MasterKey,32);
+		sha.finish(FinalKey);
+		
+		Algorithm = algorithm;
+		memcpy(IV,EncryptionIV,16);
+		Sha = SHA256();
+		CryptoSize = 0;
+		Result = Pending;
+		if(Algorithm == Rijndael_Cipher){
+			Aes.key256(FinalKey);
+		}
+		else if (Twofish.init(FinalKey, 32, IV) != true){
+			Result = InitError;
+		}
+		SecString::overwrite(FinalKey,32);
+	}
+	
+	//! Decrypts the next chunk of the content into Plain.
+	/*! Only touches the candidate itself, so several candidates can decrypt the same chunk concurrently. */
+	void decrypt(const char* cipher, int size, bool last){
+		if(Result != Pending)
+			return;
+		Plain.resize(size);
+		quint8* plain = (quint8*)Plain.data();
+		if(Algorithm == Rijndael_Cipher)
+			Aes.cbc_decrypt((const unsigned char*)cipher,plain,size,IV);
+		else
+			Twofish.cbcDecrypt((quint8*)cipher,size,plain);
+		
+		if(last){
+			int padLen = plain[size-1];
+			if(padLen <= 0 || padLen > 16 || padLen > size){
+				Result = SizeError;
+				return;
+			}
+			for(int i=size-padLen;i<size;i++){
+				if(plain[i] != padLen){
+					Result = SizeError;
+					return;
+				}
+			}
+			size -= padLen;
+			memset(plain+size,0,padLen);
+			Plain.resize(size);
+		}
+	}
+	
+	//! Adds the last decrypted chunk to the content hash.
+	void hash(){
+		if(Result != Pending)
+			return;
+		Sha.update(Plain.data(),Plain.size());
+		CryptoSize += Plain.size();
+	}
+	
+	void decryptAndHash(const char* cipher, int size, bool last){
+		decrypt(cipher,size,last);
+		hash();
+	}
+	
+	//! Compares the content hash with ContentsHash after the last chunk.
+	void verify(const quint8* ContentsHash, quint32 NumGroups){
+		if(Result != Pending)
+			return;
+		if ((CryptoSize > 2147483446) || (!CryptoSize && NumGroups)){
+			Result = SizeError;
+			return;
+		}
+		quint8 hash[32];
+		Sha.finish(hash);
+		Result = memcmp(ContentsHash, hash, 32) == 0 ? Success : HashError;
+	}
+	
+	quint8 MasterKey[32];
+	CryptAlgorithm Algorithm;
+	quint8 IV[16];
+	AESdecrypt Aes;
+	CTwofish Twofish;
+	SHA256 Sha;
+	QByteArray Plain; //!< decrypted data of the last chunk
+	unsigned long CryptoSize;
+	int Result;
+};
+
+//! State of the field parser while the database content is streamed in.
+struct Kdb3Database::ReadState{
+	ReadState() : NumGroups(0), NumEntries(0) {}
+	~ReadState(){
+		Pending.fill(0);
+	}
+	
+	quint32 NumGroups;
+	quint32 NumEntries;
+	quint32 CurGroup;
+	quint32 CurEntry;
+	StdGroup Group;
+	StdEntry Entry;
+	QList<quint32> Levels;
+	QByteArray Pending; //!< decrypted data which does not contain a complete field yet
+	bool Failed;
+	QString Error;
+};
+
+//! Returns the nanoseconds since the clock was started and starts it again.
+static qint64 lap(QElapsedTimer& Clock){
+	qint64 NSecs = Clock.nsecsElapsed();
+	Clock.start();
+	return NSecs;
+}
+
+//! Reads, decrypts and hashes the content with all candidates in one pass over the file.
+/*!
+  The file is read in chunks of ContentChunkSize. The plaintext of the first candidate is passed
+  to the field parser while it is still in the cache, the other candidates only decrypt and hash
+  the same chunk concurrently. Afterwards verify() tells which of the candidates is the right one.
+  With stage timing the steps are summed up over all chunks and recorded as the stages "read",
+  "decrypt", "hash" and "parse".
+*/
+void Kdb3Database::readContent(DecryptCandidate* Candidates, int NumCandidates, ReadState& State){
+	Groups.clear();
+	Entries.clear();
+	GroupsById.clear();
+	EntriesByUuid.clear();
+	State.CurGroup = 0;
+	State.CurEntry = 0;
+	State.Group = StdGroup();
+	State.Entry = StdEntry();
+	State.Levels.clear();
+	State.Pending.clear();
+	State.Failed = false;
+	State.Error.clear();
+	
+	qint64 remaining = File->size()-DB_HEADER_SIZE;
+	if(remaining <= 0 || (remaining % 16) != 0 || !File->seek(DB_HEADER_SIZE)){
+		for(int i=0;i<NumCandidates;i++)
+			Candidates[i].Result = DecryptCandidate::SizeError;
+		return;
+	}
+	
+	qint64 ContentSize = remaining;
+	qint64 ReadNSecs = 0, DecryptNSecs = 0, HashNSecs = 0, ParseNSecs = 0, ParseBytes = 0;
+	QElapsedTimer StepClock;
+	StepClock.start();
+	
+	QByteArray chunk;
+	while(remaining > 0){
+		int size = (int)qMin<qint64>(remaining, ContentChunkSize);
+		chunk.resize(size);
+		if(File->read(chunk.data(),size) != size){
+			for(int i=0;i<NumCandidates;i++)
+				Candidates[i].Result = DecryptCandidate::SizeError;
+			return;
+		}
+		remaining -= size;
+		bool last = (remaining == 0);
+		ReadNSecs += lap(StepClock);
+		
+		QList< QFuture<void> > others;
+		for(int i=1;i<NumCandidates;i++)
+			others << QtConcurrent::run(&Candidates[i], &DecryptCandidate::decryptAndHash, (const char*)chunk.constData(), size, last);
+		
+		Candidates[0].decrypt(chunk.constData(),size,last);
+		DecryptNSecs += lap(StepClock);
+		Candidates[0].hash();
+		HashNSecs += lap(StepClock);
+		if(Candidates[0].Result == DecryptCandidate::Pending && !State.Failed &&
+		   (State.CurGroup < State.NumGroups || State.CurEntry < State.NumEntries)){
+			State.Pending.append(Candidates[0].Plain);
+			ParseBytes += Candidates[0].Plain.size();
+			readFields(State);
+		}
+		ParseNSecs += lap(StepClock);
+		
+		// waiting for the other candidates is counted as decryption, they decrypt and hash the same chunk
+		for(int i=0;i<others.size();i++)
+			others[i].waitForFinished();
+		DecryptNSecs += lap(StepClock);
+	}
+	
+	if(StageTiming){
+		Stage stages[] = {
+			{"read", ReadNSecs, ContentSize},
+			{"decrypt", DecryptNSecs, ContentSize},
+			{"hash", HashNSecs, ContentSize},
+			{"parse", ParseNSecs, ParseBytes}
+		};
+		for(int i=0;i<4;i++)
+			Stages << stages[i];
+		// the next stage starts after the content
+		StageClock.start();
+	}
+	
+	if(!State.Failed){
+		if(State.CurGroup < State.NumGroups){
+			State.Failed = true;
+			State.Error = tr("Unexpected error: Offset is out of range.").append(" [G1]");
+		}
+		else if(State.CurEntry < State.NumEntries){
+			State.Failed = true;
+			State.Error = tr("Unexpected error: Offset is out of range.").append(" [E1]");
+		}
+	}
+}
+
+//! Returns the size of a field which is read with a fixed width or 0 if its size is variable.
+/*! The fields are parsed before the content hash is verified, so the size must be checked before reading. */
+static quint32 fixedFieldSize(bool IsGroup, quint16 FieldType){
+	if(IsGroup){
+		switch(FieldType){
+		case 0x0001: // id
+		case 0x0007: // image
+			return 4;
+		case 0x0008: // level
+			return 2;
+		}
+	}
+	else{
+		switch(FieldType){
+		case 0x0001: // uuid
+			return 16;
+		case 0x0002: // group id
+		case 0x0003: // image
+			return 4;
+		case 0x0009: // creation
+		case 0x000A: // last modification
+		case 0x000B: // last access
+		case 0x000C: // expiration
+			return 5;
+		}
+	}
+	return 0;
+}
+
+//! Parses all complete fields from State.Pending, incomplete data stays there for the next chunk.
+void Kdb3Database::readFields(ReadState& State){
+	char* data = State.Pending.data();
+	int size = State.Pending.size();
+	int pos = 0;
+	quint16 FieldType;
+	quint32 FieldSize;
+	bool bRet;
+	
+	while(State.CurGroup < State.NumGroups || State.CurEntry < State.NumEntries){
+		if(size - pos < 6)
+			break;
+		memcpyFromLEnd16(&FieldType, data+pos);
+		memcpyFromLEnd32(&FieldSize, data+pos+2);
+		if(FieldSize > quint32(size - pos - 6))
+			break;
+		quint8* pField = (quint8*)data+pos+6;
+		
+		bool IsGroup = State.CurGroup < State.NumGroups;
+		quint32 FixedSize = fixedFieldSize(IsGroup, FieldType);
+		if(FixedSize && FieldSize != FixedSize){
+			State.Failed = true;
+			State.Error = tr("Unexpected error: Invalid field size.").append(IsGroup ? " [G2]" : " [E2]");
+			break;
+		}
+		
+		if(IsGroup){
+			bRet = readGroupField(&State.Group,State.Levels, FieldType, pField);
+			if ((FieldType == 0xFFFF) && (bRet == true)){
+				Groups << State.Group;
+				State.CurGroup++; // Now and ONLY now the counter gets increased
+			}
+		}
+		else{
+			bRet = readEntryField(&State.Entry,FieldType,FieldSize,pField);
+			if((FieldType == 0xFFFF) && (bRet == true)){
+				Entries << State.Entry;
+				State.CurEntry++;
+			}
+		}
+		pos += 6+FieldSize;
+	}
+	
+	memset(data,0,pos);
+	State.Pending.remove(0,pos);
 }
 
 #define LOAD_RETURN_CLEANUP \
 	delete File; \
 	File = NULL; \
-	delete[] buffer; \
 	return false;
 
-bool Kdb3Database::loadReal(QString filename, bool readOnly, bool differentEncoding) {
+bool Kdb3Database::loadReal(QString filename, bool readOnly) {
+	beginStages();
 	File = new QFile(filename);
 	if (readOnly) {
 		if(!File->open(QIODevice::ReadOnly)){
@@ -557,20 +876,19 @@ bool Kdb3Database::loadReal(QString filename, bool readOnly, bool differentEncod
 	
 	openedReadOnly = readOnly;
 	
-	unsigned long total_size,crypto_size;
+	unsigned long total_size;
 	quint32 Signature1,Signature2,Version,NumGroups,NumEntries,Flags;
 	quint8 FinalRandomSeed[16];
 	quint8 ContentsHash[32];
 	quint8 EncryptionIV[16];
+	char buffer[DB_HEADER_SIZE];
 	
 	total_size=File->size();
-	char* buffer = new char[total_size];
-	File->read(buffer,total_size);
-	
 	if(total_size < DB_HEADER_SIZE){
 		error=tr("Unexpected file size (DB_TOTAL_SIZE < DB_HEADER_SIZE)");
 		LOAD_RETURN_CLEANUP
 	}
+	File->read(buffer,DB_HEADER_SIZE);
 	
 	memcpyFromLEnd32(&Signature1,buffer);
 	memcpyFromLEnd32(&Signature2,buffer+4);
@@ -602,159 +920,136 @@ bool Kdb3Database::loadReal(QString filename, bool readOnly, bool differentEncod
 		error=tr("Unknown Encryption Algorithm.");
 		LOAD_RETURN_CLEANUP
 	}
+	endStage("read header",DB_HEADER_SIZE);
+	
+	// The key set by the user is tried first. KeePassX used other encodings
+	// for non-ASCII passwords in older versions, so the Latin-1 and UTF-8
+	// variants of the password are tried as well if they differ from it.
+	QList<SecData*> RawKeys;
+	RawKeys << &RawMasterKey;
+	if(PotentialEncodingIssueLatin1)
+		RawKeys << &RawMasterKey_Latin1;
+	if(PotentialEncodingIssueUTF8)
+		RawKeys << &RawMasterKey_UTF8;
+	PotentialEncodingIssueLatin1 = false;
+	PotentialEncodingIssueUTF8 = false;
 	
-	RawMasterKey.unlock();
-	MasterKey.unlock();
-	KeyTransform::transform(*RawMasterKey,*MasterKey,TransfRandomSeed,KeyTransfRounds);
-	
-	quint8 FinalKey[32];
-	
-	SHA256 sha;
-	sha.update(FinalRandomSeed,16);
-	sha.update(*MasterKey,32);
-	sha.finish(FinalKey);
-	
-	RawMasterKey.lock();
-	MasterKey.lock();
-	
-	if(Algorithm == Rijndael_Cipher){
-		AESdecrypt aes;
-		aes.key256(FinalKey);
-		aes.cbc_decrypt((unsigned char*)buffer+DB_HEADER_SIZE,(unsigned char*)buffer+DB_HEADER_SIZE,total_size-DB_HEADER_SIZE,(unsigned char*)EncryptionIV);
-		crypto_size=total_size-((quint8*)buffer)[total_size-1]-DB_HEADER_SIZE;
-	}
-	else if(Algorithm == Twofish_Cipher){
-		CTwofish twofish;
-		if (twofish.init(FinalKey, 32, EncryptionIV) != true){
-			error=tr("Unable to initialize the twofish algorithm.");
-			LOAD_RETURN_CLEANUP
-		}
-		crypto_size = (unsigned long)twofish.padDecrypt((quint8 *)buffer + DB_HEADER_SIZE,
-		total_size - DB_HEADER_SIZE, (quint8 *)buffer + DB_HEADER_SIZE);
-	}
-	else{
-		error=tr("Unknown encryption algorithm.");
-		LOAD_RETURN_CLEANUP
-	}
-	
-	if ((crypto_size > 2147483446) || (!crypto_size && NumGroups)){
-        error=tr("Decryption failed. The password is wrong or the file is damaged.");
-		KeyError=true;
-		LOAD_RETURN_CLEANUP
-	}
-	SHA256::hashBuffer(buffer+DB_HEADER_SIZE,FinalKey,crypto_size);
-	
-	if(memcmp(ContentsHash, FinalKey, 32) != 0){
-		if(PotentialEncodingIssueLatin1){
-			delete[] buffer;
-			delete File;
-			File = NULL;
-			
-			RawMasterKey.copyData(RawMasterKey_Latin1);
-			PotentialEncodingIssueLatin1 = false;
-			qDebug("Decryption failed. Retrying with Latin-1.");
-			return loadReal(filename, readOnly, true); // second try
-		}
-		if(PotentialEncodingIssueUTF8){
-			delete[] buffer;
-			delete File;
-			File = NULL;
-			
-			RawMasterKey.copyData(RawMasterKey_UTF8);
-			PotentialEncodingIssueUTF8 = false;
-			qDebug("Decryption failed. Retrying with UTF-8.");
-			return loadReal(filename, readOnly, true); // second/third try
-		}
-        error=tr("Hash test failed. The password is wrong or the key file is damaged.");
-		KeyError=true;
-		LOAD_RETURN_CLEANUP
-	}
-	
-	unsigned long pos = DB_HEADER_SIZE;
-	quint16 FieldType;
-	quint32 FieldSize;
-	char* pField;
-	bool bRet;
-	StdGroup group;
-	QList<quint32> Levels;
+	// With more than one candidate all keys are transformed at the same time
+	// and checked in the same pass over the file, so a wrong encoding does
+	// not multiply the unlock time. Otherwise the candidates are tried one
+	// after the other.
+	DecryptCandidate Candidates[3];
+	int NumCandidates = RawKeys.size();
+	bool speculative = SpeculativeDecryption && NumCandidates > 1;
+	
+	ReadState State;
+	State.NumGroups = NumGroups;
+	State.NumEntries = NumEntries;
 	RootGroup.Title="$ROOT$";
 	RootGroup.Parent=NULL;
 	RootGroup.Handle=NULL;
-	
-	for(unsigned long CurGroup = 0; CurGroup < NumGroups; )
-	{
-		pField = buffer+pos;
-	
-		memcpyFromLEnd16(&FieldType, pField);
-		pField += 2; pos += 2;
-		if (pos >= total_size){
-			error=tr("Unexpected error: Offset is out of range.").append(" [G1]");
-			LOAD_RETURN_CLEANUP
+	RootGroup.ChildrenSorted=false;
+	
+	int found = -1;
+	if(speculative){
+		QList<KeyTransformTask> tasks;
+		for(int i=0;i<NumCandidates;i++){
+			RawKeys[i]->unlock();
+			KeyTransformTask task = {**RawKeys[i], Candidates[i].MasterKey};
+			tasks << task;
 		}
-	
-		memcpyFromLEnd32(&FieldSize, pField);
-		pField += 4; pos += 4;
-		if (pos >= (total_size + FieldSize)){
-			error=tr("Unexpected error: Offset is out of range.").append(" [G2]");
-			LOAD_RETURN_CLEANUP
+		KeyTransform::transform(tasks,TransfRandomSeed,KeyTransfRounds);
+		for(int i=0;i<NumCandidates;i++)
+			RawKeys[i]->lock();
+		endStage("key transformation");
+		
+		// initialized here and not in the candidate threads, because CTwofish
+		// sets up the shared Twofish tables on first use
+		for(int i=0;i<NumCandidates;i++)
+			Candidates[i].init(Algorithm,FinalRandomSeed,EncryptionIV);
+		readContent(Candidates,NumCandidates,State);
+		for(int i=0;i<NumCandidates;i++){
+			Candidates[i].verify(ContentsHash,NumGroups);
+			if(found < 0 && Candidates[i].Result == DecryptCandidate::Success)
+				found = i;
 		}
-	
-		bRet = readGroupField(&group,Levels, FieldType, (quint8 *)pField);
-		if ((FieldType == 0xFFFF) && (bRet == true)){
-			Groups << group;
-			CurGroup++; // Now and ONLY now the counter gets increased
+		
+		// the fields were parsed with the first candidate, parse again with the right one
+		if(found > 0){
+			Candidates[found].init(Algorithm,FinalRandomSeed,EncryptionIV);
+			readContent(&Candidates[found],1,State);
+			Candidates[found].verify(ContentsHash,NumGroups);
+			if(Candidates[found].Result != DecryptCandidate::Success)
+				found = -1;
 		}
-		pField += FieldSize;
-		pos += FieldSize;
-		if (pos >= total_size){
-			error=tr("Unexpected error: Offset is out of range.").append(" [G1]");
-			LOAD_RETURN_CLEANUP
+		endStage("verify");
+	}
+	else{
+		for(int i=0;i<NumCandidates;i++){
+			if(i > 0)
+				qDebug("Decryption failed. Retrying with a different password encoding.");
+			RawKeys[i]->unlock();
+			KeyTransform::transform(**RawKeys[i],Candidates[i].MasterKey,TransfRandomSeed,KeyTransfRounds);
+			RawKeys[i]->lock();
+			endStage("key transformation");
+			Candidates[i].init(Algorithm,FinalRandomSeed,EncryptionIV);
+			readContent(&Candidates[i],1,State);
+			Candidates[i].verify(ContentsHash,NumGroups);
+			endStage("verify");
+			if(Candidates[i].Result == DecryptCandidate::Success){
+				found = i;
+				break;
+			}
 		}
 	}
 	
-	StdEntry entry;
-	
-	for (unsigned long CurEntry = 0; CurEntry < NumEntries;)
-	{
-		pField = buffer+pos;
-	
-		memcpyFromLEnd16(&FieldType, pField);
-		pField += 2; pos += 2;
-		if(pos >= total_size){
-			error=tr("Unexpected error: Offset is out of range.").append(" [E1]");
-			LOAD_RETURN_CLEANUP
-		}
+	// nothing of the content is kept if it could not be verified or parsed
+	if(found < 0 || State.Failed){
+		Groups.clear();
+		Entries.clear();
+		GroupsById.clear();
+		EntriesByUuid.clear();
+		State.Group = StdGroup();
+		State.Entry = StdEntry();
+		State.Levels.clear();
+	}
 	
-		memcpyFromLEnd32(&FieldSize, pField);
-		pField += 4; pos += 4;
-		if (pos >= (total_size + FieldSize)){
-			error=tr("Unexpected error: Offset is out of range.").append(" [E2]");
-			LOAD_RETURN_CLEANUP
+	if(found < 0){
+		// report the error of the key set by the user
+		switch(Candidates[0].Result){
+			case DecryptCandidate::InitError:
+				error=tr("Unable to initialize the twofish algorithm.");
+				break;
+			case DecryptCandidate::SizeError:
+				error=tr("Decryption failed. The password is wrong or the file is damaged.");
+				KeyError=true;
+				break;
+			default:
+				error=tr("Hash test failed. The password is wrong or the key file is damaged.");
+				KeyError=true;
+				break;
 		}
+		LOAD_RETURN_CLEANUP
+	}
 	
-		bRet = readEntryField(&entry,FieldType,FieldSize,(quint8*)pField);
+	if(State.Failed){
+		error=State.Error;
+		LOAD_RETURN_CLEANUP
+	}
 	
-		if((FieldType == 0xFFFF) && (bRet == true)){
-			Entries << entry;
-			if(!entry.GroupId)
-				qDebug("NULL: %i, '%s'", (int)CurEntry, (char*)entry.Title.toUtf8().data());
-			CurEntry++;
-		}
+	if(found > 0)
+		qDebug("Decryption succeeded with a different password encoding.");
+	bool differentEncoding = found > 0;
 	
-		pField += FieldSize;
-		pos += FieldSize;
-		if (pos >= total_size){
-			error=tr("Unexpected error: Offset is out of range.").append(" [E3]");
-			LOAD_RETURN_CLEANUP
-		}
-	}
+	MasterKey.unlock();
+	memcpy(*MasterKey,Candidates[found].MasterKey,32);
+	MasterKey.lock();
 	
-	if(!createGroupTree(Levels)){
+	if(!createGroupTree(State.Levels)){
 		error=tr("Invalid group tree.");
 		LOAD_RETURN_CLEANUP
 	}
-	
-	delete [] buffer;
+	endStage("group tree");
 	
 	hasV4IconMetaStream = false;
 	for(int i=0;i<Entries.size();i++){
@@ -769,25 +1064,20 @@ bool Kdb3Database::loadReal(QString filename, bool readOnly, bool differentEncod
 		if(isMetaStream(Entries[i])){
 			if(!parseMetaStream(Entries[i]))
 				UnknownMetaStreams << Entries[i];
+			removeFromEntryIndex(&Entries[i]);
 			Entries.removeAt(i);
 			i--;
 		}
 	}
 	
-	int* EntryIndices=new int[Groups.size()];
-	for(int i=0;i<Groups.size();i++)EntryIndices[i]=0;
-	
-	for(int g=0;g<Groups.size();g++){
-		for(int e=0;e<Entries.size();e++){
-			if(Entries[e].GroupId==Groups[g].Id){
-				Entries[e].Index=EntryIndices[g];
-				EntryIndices[g]++;
-			}
-		}
+	for(int e=0;e<Entries.size();e++){
+		Entries[e].ListIndex=e;
+		Entries[e].Index=Entries[e].Group->Entries.size();
+		Entries[e].Group->Entries.append(&Entries[e]);
 	}
-	delete [] EntryIndices;
 	createHandles();
 	restoreGroupTreeState();
+	endStage("handles");
 	
 	passwordEncodingChanged = differentEncoding;
 	if (differentEncoding) {
@@ -840,10 +1130,13 @@ void Kdb3Database::deleteGroup(StdGroup* group){
 
 	Q_ASSERT(group==group->Parent->Children[group->Index]);
 	group->Parent->Children.removeAt(group->Index);
+	group->Parent->ChildrenSorted=false;
 	for(int i=group->Index;i<group->Parent->Children.size();i++){
 		group->Parent->Children[i]->Index--;
 	}
 	group->Handle->invalidate();
+	if(GroupsById.value(group->Id)==group)
+		GroupsById.remove(group->Id);
 
 	for(int i=0;i<Groups.size();i++){
 		if(&Groups[i]==group){
@@ -1042,59 +1335,157 @@ QList<IEntryHandle*> Kdb3Database::expiredEntries(){
 
 QList<IEntryHandle*> Kdb3Database::entries(IGroupHandle* Group){
 	QList<IEntryHandle*> handles;
-	for(int i=0; i<EntryHandles.size(); i++){
-		if(EntryHandles[i].isValid() && (EntryHandles[i].group()==Group))
-			handles.append(&EntryHandles[i]);
+	if(!Group)
+		return handles;
+	// the entry list of the group is already ordered by the index of the entries
+	const QList<StdEntry*>& GroupEntries=((GroupHandle*)Group)->Group->Entries;
+	handles.reserve(GroupEntries.size());
+	for(int i=0; i<GroupEntries.size(); i++){
+		handles.append(GroupEntries[i]->Handle);
 	}
-	qSort(handles.begin(),handles.end(),EntryHandleLessThan);
 
 	return handles;
 }
 
 QList<IEntryHandle*> Kdb3Database::entriesSortedStd(IGroupHandle* Group){
 	QList<IEntryHandle*> handles;
-	for(int i=0; i<EntryHandles.size(); i++){
-		if(EntryHandles[i].isValid() && (EntryHandles[i].group()==Group))
-			handles.append(&EntryHandles[i]);
+	if(!Group)
+		return handles;
+	const QList<StdEntry*>& SortedEntries=sortedEntries(((GroupHandle*)Group)->Group);
+	handles.reserve(SortedEntries.size());
+	for(int i=0; i<SortedEntries.size(); i++){
+		handles.append(SortedEntries[i]->Handle);
+	}
+
+	return handles;
+}
+
+QList<IGroupHandle*> Kdb3Database::sortedChildren(IGroupHandle* Group){
+	QList<IGroupHandle*> handles;
+	if(!Group)
+		return handles;
+	const QList<StdGroup*>& SortedChildren=sortedChildren(((GroupHandle*)Group)->Group);
+	handles.reserve(SortedChildren.size());
+	for(int i=0; i<SortedChildren.size(); i++){
+		handles.append(SortedChildren[i]->Handle);
 	}
-	qSort(handles.begin(),handles.end(),EntryHandleLessThanStd);
 
 	return handles;
 }
 
+//! Returns the entries of a group sorted by title and username.
+/*! The order is computed once and kept until an entry of the group is added, removed or renamed. */
+const QList<Kdb3Database::StdEntry*>& Kdb3Database::sortedEntries(StdGroup* group){
+	if(!group->EntriesSorted){
+		group->SortedEntries=group->Entries;
+		for(int i=0; i<group->SortedEntries.size(); i++){
+			StdEntry* entry=group->SortedEntries[i];
+			if(entry->SortKey.isEmpty())
+				entry->SortKey=entry->Title.toCaseFolded()+QChar(0)+entry->Username.toCaseFolded();
+		}
+		qStableSort(group->SortedEntries.begin(),group->SortedEntries.end(),StdEntrySortKeyLessThan);
+		group->EntriesSorted=true;
+	}
+	return group->SortedEntries;
+}
+
+//! Returns the subgroups of a group sorted by title.
+/*! The order is computed once and kept until a subgroup is added, removed or renamed. */
+const QList<Kdb3Database::StdGroup*>& Kdb3Database::sortedChildren(StdGroup* group){
+	if(!group->ChildrenSorted){
+		group->SortedChildren=group->Children;
+		for(int i=0; i<group->SortedChildren.size(); i++){
+			StdGroup* child=group->SortedChildren[i];
+			if(child->SortKey.isEmpty())
+				child->SortKey=child->Title.toCaseFolded();
+		}
+		qStableSort(group->SortedChildren.begin(),group->SortedChildren.end(),StdGroupSortKeyLessThan);
+		group->ChildrenSorted=true;
+	}
+	return group->SortedChildren;
+}
+
+//! Appends an entry to the entry list of a group.
+void Kdb3Database::attachEntry(StdEntry* entry, StdGroup* group){
+	entry->Group=group;
+	entry->GroupId=group->Id;
+	entry->Index=group->Entries.size();
+	group->Entries.append(entry);
+	group->EntriesSorted=false;
+}
+
+//! Removes an entry from the entry list of its group.
+void Kdb3Database::detachEntry(StdEntry* entry){
+	StdGroup* group=entry->Group;
+	Q_ASSERT(group->Entries[entry->Index]==entry);
+	group->Entries.removeAt(entry->Index);
+	group->EntriesSorted=false;
+	renumberEntries(group,entry->Index);
+}
+
+void Kdb3Database::renumberEntries(StdGroup* group, int from){
+	for(int i=from;i<group->Entries.size();i++){
+		group->Entries[i]->Index=i;
+	}
+}
+
 void Kdb3Database::deleteEntry(IEntryHandle* entry){
 	if(!entry)return;
-	int j;
-	for(j=0;j<Entries.size();j++){
-		if(&Entries[j]==((EntryHandle*)entry)->Entry)
-			break;
+	StdEntry* Entry=((EntryHandle*)entry)->Entry;
+	int j=Entry->ListIndex;
+	// the position is only searched if the hint is outdated
+	if(j<0 || j>=Entries.size() || &Entries[j]!=Entry){
+		for(j=0;j<Entries.size();j++){
+			if(&Entries[j]==Entry)
+				break;
+		}
+	}
+	Entry->Handle->invalidate();
+	detachEntry(Entry);
+	removeFromEntryIndex(Entry);
+	// The last entry takes the place of the deleted one. QList only swaps the pointers to its
+	// items, so the addresses of the entries stay the same for handles and EntriesByUuid.
+	int last=Entries.size()-1;
+	if(j!=last){
+		Entries.swap(j,last);
+		Entries[j].ListIndex=j;
 	}
-	Entries[j].Handle->invalidate();
-	Entries.removeAt(j);
+	Entries.removeLast();
 }
 
 void Kdb3Database::moveEntry(IEntryHandle* entry, IGroupHandle* group){
-	((EntryHandle*)entry)->Entry->GroupId=((GroupHandle*)group)->Group->Id;
-	((EntryHandle*)entry)->Entry->Group=((GroupHandle*)group)->Group;
+	StdEntry* Entry=((EntryHandle*)entry)->Entry;
+	detachEntry(Entry);
+	attachEntry(Entry,((GroupHandle*)group)->Group);
+	Entry->invalidateRecord();
 }
 
 
 void Kdb3Database::deleteEntries(QList<IEntryHandle*> entries){
 	if(!entries.size())return;
-	StdGroup* Group=((EntryHandle*)entries[0])->Entry->Group;
+	QSet<StdEntry*> DeletedEntries;
+	QSet<StdGroup*> AffectedGroups;
 	for(int i=0;i<entries.size();i++){
-		int j;
-		for(j=0;j<Entries.size();j++){
-			if(&Entries[j]==((EntryHandle*)entries[i])->Entry)
-				break;
-		}
-		Group->Children.removeAt(Entries[j].Index);
-		Entries[j].Handle->invalidate();
-		Entries.removeAt(j);
-	}
-
-	for(int i=0;i<Group->Children.size();i++){
-		Group->Children[i]->Index=i;
+		StdEntry* Entry=((EntryHandle*)entries[i])->Entry;
+		// only mark the entry in the list of its group, the lists are compacted below
+		Entry->Group->Entries[Entry->Index]=NULL;
+		AffectedGroups.insert(Entry->Group);
+		Entry->Handle->invalidate();
+		removeFromEntryIndex(Entry);
+		DeletedEntries.insert(Entry);
+	}
+	for(QSet<StdGroup*>::iterator it=AffectedGroups.begin();it!=AffectedGroups.end();++it){
+		(*it)->Entries.removeAll(NULL);
+		(*it)->EntriesSorted=false;
+		renumberEntries(*it,0);
+	}
+	// remove all of them in one pass over the entry list
+	for(int j=Entries.size()-1;j>=0 && !DeletedEntries.isEmpty();j--){
+		if(DeletedEntries.remove(&Entries[j]))
+			Entries.removeAt(j);
+	}
+	for(int j=0;j<Entries.size();j++){
+		Entries[j].ListIndex=j;
 	}
 };
 
@@ -1113,12 +1504,7 @@ quint32 Kdb3Database::getNewGroupId(){
 		used=false;
 		randomize(&id,4);
 		if(!id)continue; //group IDs must not be 0
-		for(int j=0;j<Groups.size();j++){
-			if(Groups[j].Id==id){
-				used=true;
-				break;
-			}
-		}
+		used=GroupsById.contains(id);
 	} while(used);
 	return id;
 }
@@ -1127,12 +1513,14 @@ IGroupHandle* Kdb3Database::addGroup(const CGroup* group,IGroupHandle* ParentHan
 	GroupHandles.append(GroupHandle(this));
 	Groups.append(*group);
 	Groups.back().Id=getNewGroupId();
+	GroupsById.insert(Groups.back().Id,&Groups.back());
 	Groups.back().Handle=&GroupHandles.back();
 	GroupHandles.back().Group=&Groups.back();
 	if(ParentHandle){
 		Groups.back().Parent=((GroupHandle*)ParentHandle)->Group;
 		Groups.back().Index=Groups.back().Parent->Children.size();
 		Groups.back().Parent->Children.append(&Groups.back());
+		Groups.back().Parent->ChildrenSorted=false;
 	}
 	else{
 		// Insert to root group. Try to keep Backup group at the end.
@@ -1145,6 +1533,7 @@ IGroupHandle* Kdb3Database::addGroup(const CGroup* group,IGroupHandle* ParentHan
 			position--;
 		}
 		RootGroup.Children.insert(position, &Groups.back());
+		RootGroup.ChildrenSorted=false;
 	}
 	return &GroupHandles.back();
 }
@@ -1170,8 +1559,17 @@ IGroupHandle* Kdb3Database::backupGroup(bool create){
 }
 
 Kdb3Database::StdEntry::StdEntry(){
+	ListIndex = -1;
 	Handle = NULL;
 	Group = NULL;
+	RecordPasswordPos = 0;
+}
+
+//! Called when the title or username changes, the entry needs to be sorted again within its group.
+void Kdb3Database::StdEntry::invalidateSortKey(){
+	SortKey.clear();
+	if(Group)
+		Group->EntriesSorted=false;
 }
 
 Kdb3Database::StdGroup::StdGroup(){
@@ -1179,6 +1577,8 @@ Kdb3Database::StdGroup::StdGroup(){
 	Id=0;
 	Parent=NULL;
 	Handle=NULL;
+	ChildrenSorted=false;
+	EntriesSorted=false;
 }
 
 Kdb3Database::StdGroup::StdGroup(const CGroup& other){
@@ -1188,20 +1588,29 @@ Kdb3Database::StdGroup::StdGroup(const CGroup& other){
 	Title=other.Title;
 	Parent=NULL;
 	Handle=NULL;
+	ChildrenSorted=false;
+	EntriesSorted=false;
 }
 
-void Kdb3Database::EntryHandle::setTitle(const QString& Title){Entry->Title=Title; }
-void Kdb3Database::EntryHandle::setUsername(const QString& Username){Entry->Username=Username;}
-void Kdb3Database::EntryHandle::setUrl(const QString& Url){Entry->Url=Url;}
+//! Called when the title changes, the group needs to be sorted again within its parent.
+void Kdb3Database::StdGroup::invalidateSortKey(){
+	SortKey.clear();
+	if(Parent)
+		Parent->ChildrenSorted=false;
+}
+
+void Kdb3Database::EntryHandle::setTitle(const QString& Title){Entry->Title=Title; Entry->invalidateRecord(); Entry->invalidateSortKey();}
+void Kdb3Database::EntryHandle::setUsername(const QString& Username){Entry->Username=Username; Entry->invalidateRecord(); Entry->invalidateSortKey();}
+void Kdb3Database::EntryHandle::setUrl(const QString& Url){Entry->Url=Url; Entry->invalidateRecord();}
 void Kdb3Database::EntryHandle::setPassword(const SecString& Password){Entry->Password=Password;}
-void Kdb3Database::EntryHandle::setExpire(const KpxDateTime& s){Entry->Expire=s;}
-void Kdb3Database::EntryHandle::setCreation(const KpxDateTime& s){Entry->Creation=s;}
-void Kdb3Database::EntryHandle::setLastAccess(const KpxDateTime& s){Entry->LastAccess=s;}
-void Kdb3Database::EntryHandle::setLastMod(const KpxDateTime& s){Entry->LastMod=s;}
-void Kdb3Database::EntryHandle::setBinaryDesc(const QString& s){Entry->BinaryDesc=s;}
-void Kdb3Database::EntryHandle::setComment(const QString& s){Entry->Comment=s;}
-void Kdb3Database::EntryHandle::setBinary(const QByteArray& s){Entry->Binary=s;}
-void Kdb3Database::EntryHandle::setImage(const quint32& s){Entry->Image=s;}
+void Kdb3Database::EntryHandle::setExpire(const KpxDateTime& s){Entry->Expire=s; Entry->invalidateRecord();}
+void Kdb3Database::EntryHandle::setCreation(const KpxDateTime& s){Entry->Creation=s; Entry->invalidateRecord();}
+void Kdb3Database::EntryHandle::setLastAccess(const KpxDateTime& s){Entry->LastAccess=s; Entry->invalidateRecord();}
+void Kdb3Database::EntryHandle::setLastMod(const KpxDateTime& s){Entry->LastMod=s; Entry->invalidateRecord();}
+void Kdb3Database::EntryHandle::setBinaryDesc(const QString& s){Entry->BinaryDesc=s; Entry->invalidateRecord();}
+void Kdb3Database::EntryHandle::setComment(const QString& s){Entry->Comment=s; Entry->invalidateRecord();}
+void Kdb3Database::EntryHandle::setBinary(const QByteArray& s){Entry->Binary=s; Entry->invalidateRecord();}
+void Kdb3Database::EntryHandle::setImage(const quint32& s){Entry->Image=s; Entry->invalidateRecord();}
 KpxUuid	Kdb3Database::EntryHandle::uuid()const{return Entry->Uuid;}
 IGroupHandle* Kdb3Database::EntryHandle::group()const{return Entry->Group->Handle;}
 quint32	Kdb3Database::EntryHandle::image()const{return Entry->Image;}
@@ -1263,11 +1672,8 @@ CEntry Kdb3Database::EntryHandle::data()const{
 }
 
 void Kdb3Database::EntryHandle::setVisualIndex(int index){
-	QList<IEntryHandle*>Entries=pDB->entries(Entry->Group->Handle);
-	Entries.move(visualIndex(),index);
-	for(int i=0;i<Entries.size();i++){
-		dynamic_cast<Kdb3Database::EntryHandle*>(Entries[i])->Entry->Index=index;
-	}
+	Entry->Group->Entries.move(Entry->Index,index);
+	renumberEntries(Entry->Group,qMin(Entry->Index,index));
 }
 
 Kdb3Database::EntryHandle::EntryHandle(Kdb3Database* db){
@@ -1281,7 +1687,8 @@ bool Kdb3Database::GroupHandle::isValid(){return valid;}
 QString Kdb3Database::GroupHandle::title()const{return Group->Title;}
 quint32	Kdb3Database::GroupHandle::image(){return Group->Image;}
 int Kdb3Database::GroupHandle::index(){return Group->Index;}
-void Kdb3Database::GroupHandle::setTitle(const QString& Title){Group->Title=Title;}
+int Kdb3Database::GroupHandle::numEntries(){return Group->Entries.size();}
+void Kdb3Database::GroupHandle::setTitle(const QString& Title){Group->Title=Title; Group->invalidateSortKey();}
 void Kdb3Database::GroupHandle::setExpanded(bool IsExpanded){Group->IsExpanded=IsExpanded;}
 bool Kdb3Database::GroupHandle::expanded(){return Group->IsExpanded;}
 void Kdb3Database::GroupHandle::setImage(const quint32& New){Group->Image=New;}
@@ -1379,6 +1786,7 @@ bool Kdb3Database::save(){
 		error = tr("The database has been opened read-only.");
 		return false;
 	}
+	beginStages();
 
 // TODO (Marko Koschak) we need only these functions from backup - others might be deleted
 	//Delete old backup entries
@@ -1396,51 +1804,12 @@ bool Kdb3Database::save(){
 	quint8 ContentsHash[32];
 	quint8 EncryptionIV[16];
 
-	unsigned int FileSize;
-
 	QList<StdEntry> MetaStreams;
 	MetaStreams << StdEntry();
 	createCustomIconsMetaStream(&MetaStreams.back());
 	MetaStreams << StdEntry();
 	createGroupTreeStateMetaStream(&MetaStreams.back());
 
-	FileSize=DB_HEADER_SIZE;
-	// Get the size of all groups (94 Byte + length of the name string)
-	for(int i = 0; i < Groups.size(); i++){
-		FileSize += 94 + Groups[i].Title.toUtf8().length()+1;
-	}
-	// Get the size of all entries
-	for(int i = 0; i < Entries.size(); i++){
-		FileSize
-			+= 134
-			+Entries[i].Title.toUtf8().length()+1
-			+Entries[i].Username.toUtf8().length()+1
-			+Entries[i].Url.toUtf8().length()+1
-			+Entries[i].Password.length()+1
-			+Entries[i].Comment.toUtf8().length()+1
-			+Entries[i].BinaryDesc.toUtf8().length()+1
-			+Entries[i].Binary.length();
-	}
-
-	for(int i=0; i < UnknownMetaStreams.size(); i++){
-		FileSize
-			+=165
-			+UnknownMetaStreams[i].Comment.toUtf8().length()+1
-			+UnknownMetaStreams[i].Binary.length();
-	}
-
-	for(int i=0; i < MetaStreams.size(); i++){
-		FileSize
-				+=165
-				+MetaStreams[i].Comment.toUtf8().length()+1
-				+MetaStreams[i].Binary.length();
-	}
-
-
-	// Round up filesize to 16-byte boundary for Rijndael/Twofish
-	FileSize = (FileSize + 16) - (FileSize % 16);
-	char* buffer=new char[FileSize+16];
-
 	Signature1 = PWM_DBSIG_1;
 	Signature2 = PWM_DBSIG_2;
 	Flags = PWM_FLAG_SHA2;
@@ -1450,18 +1819,32 @@ bool Kdb3Database::save(){
 	NumGroups = Groups.size();
 	NumEntries = Entries.size()+UnknownMetaStreams.size()+MetaStreams.size();
 
-	QList<StdEntry> saveEntries = Entries;
+	QList<StdEntry*> saveEntries;
+	saveEntries.reserve(Entries.size());
+	for(int i = 0; i < Entries.size(); i++){
+		saveEntries << &Entries[i];
+	}
 	qSort(saveEntries.begin(),saveEntries.end(),StdEntryLessThan);
 
 	randomize(FinalRandomSeed,16);
 	randomize(EncryptionIV,16);
 
-	unsigned int pos=DB_HEADER_SIZE; // Skip the header, it will be written later
+	// The content is encoded in one pass into the buffer of the last save, so its memory is
+	// normally already allocated. Entries which did not change are copied from their cached record.
+	SaveBuffer.resize(DB_HEADER_SIZE); // Skip the header, it will be written later
+	serializeGroups(SaveBuffer);
+	for(int i = 0; i < saveEntries.size(); i++){
+		serializeEntry(*saveEntries[i],SaveBuffer);
+	}
+	serializeEntries(UnknownMetaStreams,SaveBuffer);
+	serializeEntries(MetaStreams,SaveBuffer);
+
+	unsigned int pos=SaveBuffer.size();
+	// Space for the padding of Rijndael/Twofish
+	SaveBuffer.resize(pos+16);
+	char* buffer=SaveBuffer.data();
+	endStage("serialize",pos);
 
-	serializeGroups(buffer,pos);
-	serializeEntries(saveEntries,buffer,pos);
-	serializeEntries(UnknownMetaStreams,buffer,pos);
-	serializeEntries(MetaStreams,buffer,pos);
 	SHA256::hashBuffer(buffer+DB_HEADER_SIZE,ContentsHash,pos-DB_HEADER_SIZE);
 	memcpyToLEnd32(buffer,&Signature1);
 	memcpyToLEnd32(buffer+4,&Signature2);
@@ -1482,6 +1865,7 @@ bool Kdb3Database::save(){
 	sha.update(*MasterKey,32);
 	MasterKey.lock();
 	sha.finish(FinalKey);
+	endStage("hash",pos-DB_HEADER_SIZE);
 
 	unsigned long EncryptedPartSize;
 
@@ -1498,7 +1882,8 @@ bool Kdb3Database::save(){
 		CTwofish twofish;
 		if(twofish.init(FinalKey, 32, EncryptionIV) == false){
 			UNEXP_ERROR
-			delete [] buffer;
+			// do not keep the unencrypted content in memory
+			SecString::overwrite((unsigned char*)buffer,SaveBuffer.size());
 			return false;
 		}
 		EncryptedPartSize = (unsigned long)twofish.padEncrypt((quint8*)buffer+DB_HEADER_SIZE,
@@ -1506,19 +1891,18 @@ bool Kdb3Database::save(){
 	}
 	if((EncryptedPartSize > (0xFFFFFFE - 202)) || (!EncryptedPartSize && Groups.size())){
 		UNEXP_ERROR
-		delete [] buffer;
 		return false;
 	}
 	
 	int size = EncryptedPartSize+DB_HEADER_SIZE;
+	endStage("encrypt",EncryptedPartSize);
 	
 	if (!saveFileTransactional(buffer, size)) {
 		error=decodeFileError(File->error());
-		delete [] buffer;
 		return false;
 	}
+	endStage("write",size);
 
-	delete [] buffer;
 	//if(SearchGroupID!=-1)Groups.push_back(SearchGroup);
 	return true;
 }
@@ -1623,32 +2007,18 @@ void Kdb3Database::createCustomIconsMetaStream(StdEntry* e){
 
 QList<IGroupHandle*> Kdb3Database::sortedGroups(){
     QList<IGroupHandle*> sortedGroups;
-    // first sort the list of all children from the root group
-    QList<IGroupHandle*> sortedChildren;
-    for(int i=0;i<RootGroup.Children.size();i++){
-        sortedChildren << RootGroup.Children[i]->Handle;
-    }
-    qSort(sortedChildren.begin(),sortedChildren.end(),GroupHandleLessThanStd);
-    // now go through the list of sorted children
-    for(int i=0;i<sortedChildren.size();i++){
-        sortedGroups << sortedChildren[i];
-        appendChildrenToGroupListSorted(sortedGroups,sortedChildren[i]);
-    }
+    sortedGroups.reserve(Groups.size());
+    // the sorted children of each group are cached, so only the list of handles is built here
+    appendChildrenToGroupListSorted(sortedGroups,&RootGroup);
     return sortedGroups;
 }
 
 
-void Kdb3Database::appendChildrenToGroupListSorted(QList<IGroupHandle*>& list,IGroupHandle* group){
-    // first sort the list of all children
-    QList<IGroupHandle*> sortedChildren;
-    for(int i=0;i<group->children().size();i++){
-        sortedChildren << group->children()[i];
-    }
-    qSort(sortedChildren.begin(),sortedChildren.end(),GroupHandleLessThanStd);
-    // now go through the list of sorted children
-    for(int i=0;i<sortedChildren.size();i++){
-        list << sortedChildren[i];
-        appendChildrenToGroupListSorted(list,sortedChildren[i]);
+void Kdb3Database::appendChildrenToGroupListSorted(QList<IGroupHandle*>& list,StdGroup* group){
+    const QList<StdGroup*>& children=sortedChildren(group);
+    for(int i=0;i<children.size();i++){
+        list << children[i]->Handle;
+        appendChildrenToGroupListSorted(list,children[i]);
     }
 }
 
@@ -1669,16 +2039,72 @@ void Kdb3Database::appendChildrenToGroupList(QList<StdGroup*>& list,StdGroup& gr
 }
 
 
-void Kdb3Database::serializeGroups(char* buffer,unsigned int& pos){
-	quint16 FieldType;
-	quint32 FieldSize;
+//! Appends one field with its header to the serialization buffer.
+static void appendField(QByteArray& buffer, quint16 FieldType, const char* pData, quint32 FieldSize){
+	int pos = buffer.size();
+	buffer.resize(pos + 6 + FieldSize);
+	memcpyToLEnd16(buffer.data()+pos, &FieldType);
+	memcpyToLEnd32(buffer.data()+pos+2, &FieldSize);
+	if(FieldSize)
+		memcpy(buffer.data()+pos+6, pData, FieldSize);
+}
+
+static void appendField(QByteArray& buffer, quint16 FieldType, quint32 Value){
+	char Data[4];
+	memcpyToLEnd32(Data, &Value);
+	appendField(buffer, FieldType, Data, 4);
+}
+
+//! Appends a string field, the terminating NULL character is part of the field.
+/*! The string is encoded to UTF-8 directly into the buffer, invalid surrogates are replaced by '?' like QString::toUtf8() does. */
+static void appendStringField(QByteArray& buffer, quint16 FieldType, const QString& String){
+	int pos = buffer.size();
+	int len = String.size();
+	buffer.resize(pos + 6 + 3*len + 1);
+	const ushort* src = String.utf16();
+	quint8* start = (quint8*)buffer.data() + pos + 6;
+	quint8* dst = start;
+	for(int i = 0; i < len; i++){
+		uint c = src[i];
+		if(c < 0x80){
+			*dst++ = c;
+		}
+		else if(c < 0x800){
+			*dst++ = 0xC0 | (c >> 6);
+			*dst++ = 0x80 | (c & 0x3F);
+		}
+		else if(QChar::isHighSurrogate(c) && i+1 < len && QChar::isLowSurrogate(src[i+1])){
+			c = QChar::surrogateToUcs4(ushort(c), src[++i]);
+			*dst++ = 0xF0 | (c >> 18);
+			*dst++ = 0x80 | ((c >> 12) & 0x3F);
+			*dst++ = 0x80 | ((c >> 6) & 0x3F);
+			*dst++ = 0x80 | (c & 0x3F);
+		}
+		else if(QChar::isSurrogate(c)){
+			*dst++ = '?';
+		}
+		else{
+			*dst++ = 0xE0 | (c >> 12);
+			*dst++ = 0x80 | ((c >> 6) & 0x3F);
+			*dst++ = 0x80 | (c & 0x3F);
+		}
+	}
+	*dst++ = 0;
+	quint32 FieldSize = dst - start;
+	memcpyToLEnd16(buffer.data()+pos, &FieldType);
+	memcpyToLEnd32(buffer.data()+pos+2, &FieldSize);
+	buffer.resize(pos + 6 + FieldSize);
+}
+
+void Kdb3Database::serializeGroups(QByteArray& buffer){
 	quint32 Flags=0; //unused
 	QList<StdGroup*>SortedGroups;
 	appendChildrenToGroupList(SortedGroups,RootGroup);
 
+	char Date[5];
+	dateToPackedStruct5(Date_Never,(unsigned char*)Date);
+
 	for(int i=0; i < SortedGroups.size(); i++){
-		unsigned char Date[5];
-		dateToPackedStruct5(Date_Never,Date);
 		quint16 Level=0;
 		StdGroup* group=SortedGroups[i];
 		while(group->Parent){
@@ -1686,151 +2112,78 @@ void Kdb3Database::serializeGroups(char* buffer,unsigned int& pos){
 			group=group->Parent;
 		}
 		Level--;
+		char LevelData[2];
+		memcpyToLEnd16(LevelData, &Level);
+
+		appendField(buffer, 0x0001, SortedGroups[i]->Id);
+		appendStringField(buffer, 0x0002, SortedGroups[i]->Title);
+		appendField(buffer, 0x0003, Date, 5); //Creation
+		appendField(buffer, 0x0004, Date, 5); //LastMod
+		appendField(buffer, 0x0005, Date, 5); //LastAccess
+		appendField(buffer, 0x0006, Date, 5); //Expire
+		appendField(buffer, 0x0007, SortedGroups[i]->Image);
+		appendField(buffer, 0x0008, LevelData, 2);
+		appendField(buffer, 0x0009, Flags);
+		appendField(buffer, 0xFFFF, NULL, 0);
+	}
+}
+
+//! Encodes the fields of an entry if they have changed since the last save.
+void Kdb3Database::updateRecord(StdEntry& Entry){
+	if(!Entry.Record.isEmpty())
+		return;
 
-		FieldType = 0x0001; FieldSize = 4;
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpyToLEnd32(buffer+pos, &SortedGroups[i]->Id); pos += 4;
-
-		FieldType = 0x0002; FieldSize = SortedGroups[i]->Title.toUtf8().length() + 1;
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpy(buffer+pos, SortedGroups[i]->Title.toUtf8(),FieldSize); pos += FieldSize;
-
-		FieldType = 0x0003; FieldSize = 5; //Creation
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpy(buffer+pos, Date,5); pos+=5;
-
-		FieldType = 0x0004; FieldSize = 5; //LastMod
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpy(buffer+pos, Date,5); pos+=5;
-
-		FieldType = 0x0005; FieldSize = 5; //LastAccess
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpy(buffer+pos, Date,5); pos+=5;
-
-		FieldType = 0x0006; FieldSize = 5; //Expire
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpy(buffer+pos, Date,5); pos+=5;
-
-		FieldType = 0x0007; FieldSize = 4;
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpyToLEnd32(buffer+pos, &SortedGroups[i]->Image); pos += 4;
-
-		FieldType = 0x0008; FieldSize = 2;
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpyToLEnd16(buffer+pos, &Level); pos += 2;
-
-		FieldType = 0x0009; FieldSize = 4;
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		memcpyToLEnd32(buffer+pos, &Flags); pos += 4;
-
-		FieldType = 0xFFFF; FieldSize = 0;
-		memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-	}
-
-}
-
-
-void Kdb3Database::serializeEntries(QList<StdEntry>& EntryList,char* buffer,unsigned int& pos){
-	 quint16 FieldType;
-	 quint32 FieldSize;
-	 for(int i = 0; i < EntryList.size(); i++){
-		 FieldType = 0x0001; FieldSize = 16;
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 EntryList[i].Uuid.toRaw(buffer+pos);		pos += 16;
-
-		 FieldType = 0x0002; FieldSize = 4;
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 memcpyToLEnd32(buffer+pos, &EntryList[i].GroupId); pos += 4;
-
-		 FieldType = 0x0003; FieldSize = 4;
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 memcpyToLEnd32(buffer+pos,&EntryList[i].Image); pos += 4;
-
-
-		 FieldType = 0x0004;
-		 FieldSize = EntryList[i].Title.toUtf8().length() + 1; // Add terminating NULL character space
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 memcpy(buffer+pos, EntryList[i].Title.toUtf8(),FieldSize);  pos += FieldSize;
-
-		 FieldType = 0x0005;
-		 FieldSize = EntryList[i].Url.toUtf8().length() + 1; // Add terminating NULL character space
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 memcpy(buffer+pos, EntryList[i].Url.toUtf8(),FieldSize);  pos += FieldSize;
-
-		 FieldType = 0x0006;
-		 FieldSize = EntryList[i].Username.toUtf8().length() + 1; // Add terminating NULL character space
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 memcpy(buffer+pos, EntryList[i].Username.toUtf8(),FieldSize);  pos += FieldSize;
-
-		 FieldType = 0x0007;
-		 FieldSize = EntryList[i].Password.length() + 1; // Add terminating NULL character space
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 EntryList[i].Password.unlock();
-		 memcpy(buffer+pos, EntryList[i].Password.string().toUtf8(),FieldSize);  pos += FieldSize;
-		 EntryList[i].Password.lock();
-
-		 FieldType = 0x0008;
-		 FieldSize = EntryList[i].Comment.toUtf8().length() + 1; // Add terminating NULL character space
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 memcpy(buffer+pos, EntryList[i].Comment.toUtf8(),FieldSize);  pos += FieldSize;
-
-		 FieldType = 0x0009; FieldSize = 5;
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 dateToPackedStruct5(EntryList[i].Creation,(unsigned char*)buffer+pos); pos+=5;
-
-
-		 FieldType = 0x000A; FieldSize = 5;
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 dateToPackedStruct5(EntryList[i].LastMod,(unsigned char*)buffer+pos); pos+=5;
-
-		 FieldType = 0x000B; FieldSize = 5;
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 dateToPackedStruct5(EntryList[i].LastAccess,(unsigned char*)buffer+pos); pos+=5;
-
-		 FieldType = 0x000C; FieldSize = 5;
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 dateToPackedStruct5(EntryList[i].Expire,(unsigned char*)buffer+pos); pos+=5;
-
-		 FieldType = 0x000D;
-		 FieldSize = EntryList[i].BinaryDesc.toUtf8().length() + 1; // Add terminating NULL character space
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 memcpy(buffer+pos, EntryList[i].BinaryDesc.toUtf8(),FieldSize);  pos += FieldSize;
-
-		 FieldType = 0x000E; FieldSize = EntryList[i].Binary.length();
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-		 if((!EntryList[i].Binary.isNull()) && (FieldSize != 0))
-			 memcpy(buffer+pos, EntryList[i].Binary.data(), FieldSize);
-		 pos += FieldSize;
-
-		 FieldType = 0xFFFF; FieldSize = 0;
-		 memcpyToLEnd16(buffer+pos, &FieldType); pos += 2;
-		 memcpyToLEnd32(buffer+pos, &FieldSize); pos += 4;
-	 }
- }
+	QByteArray& Record = Entry.Record;
+	char Buffer[16];
+	Record.reserve(128 + Entry.Title.size() + Entry.Url.size() + Entry.Username.size()
+		+ Entry.Comment.size() + Entry.BinaryDesc.size());
+
+	Entry.Uuid.toRaw(Buffer);
+	appendField(Record, 0x0001, Buffer, 16);
+	appendField(Record, 0x0002, Entry.GroupId);
+	appendField(Record, 0x0003, Entry.Image);
+	appendStringField(Record, 0x0004, Entry.Title);
+	appendStringField(Record, 0x0005, Entry.Url);
+	appendStringField(Record, 0x0006, Entry.Username);
+	// the password (0x0007) stays encrypted in memory and is inserted here by serializeEntry()
+	Entry.RecordPasswordPos = Record.size();
+	appendStringField(Record, 0x0008, Entry.Comment);
+	dateToPackedStruct5(Entry.Creation, (unsigned char*)Buffer);
+	appendField(Record, 0x0009, Buffer, 5);
+	dateToPackedStruct5(Entry.LastMod, (unsigned char*)Buffer);
+	appendField(Record, 0x000A, Buffer, 5);
+	dateToPackedStruct5(Entry.LastAccess, (unsigned char*)Buffer);
+	appendField(Record, 0x000B, Buffer, 5);
+	dateToPackedStruct5(Entry.Expire, (unsigned char*)Buffer);
+	appendField(Record, 0x000C, Buffer, 5);
+	appendStringField(Record, 0x000D, Entry.BinaryDesc);
+	// the attachment (0x000E) and the end marker are appended by serializeEntry(),
+	// so the attachment is not kept in memory twice
+}
+
+void Kdb3Database::serializeEntry(StdEntry& Entry,QByteArray& buffer){
+	updateRecord(Entry);
+	buffer.append(Entry.Record.constData(), Entry.RecordPasswordPos);
+
+	quint16 FieldType = 0x0007;
+	quint32 FieldSize = Entry.Password.length() + 1; // Add terminating NULL character space
+	int pos = buffer.size();
+	buffer.resize(pos + 6 + FieldSize);
+	memcpyToLEnd16(buffer.data()+pos, &FieldType);
+	memcpyToLEnd32(buffer.data()+pos+2, &FieldSize);
+	Entry.Password.copyUtf8(buffer.data()+pos+6);
+	buffer.data()[pos+6+FieldSize-1] = 0;
+
+	buffer.append(Entry.Record.constData()+Entry.RecordPasswordPos, Entry.Record.size()-Entry.RecordPasswordPos);
+	appendField(buffer, 0x000E, Entry.Binary.constData(), Entry.Binary.size());
+	appendField(buffer, 0xFFFF, NULL, 0);
+}
+
+void Kdb3Database::serializeEntries(QList<StdEntry>& EntryList,QByteArray& buffer){
+	for(int i = 0; i < EntryList.size(); i++){
+		serializeEntry(EntryList[i],buffer);
+	}
+}
 
 bool Kdb3Database::close(){
 	if (File!=NULL)
@@ -1843,6 +2196,7 @@ void Kdb3Database::create(){
 	RootGroup.Title="$ROOT$";
 	RootGroup.Parent=NULL;
 	RootGroup.Handle=NULL;
+	RootGroup.ChildrenSorted=false;
 	Algorithm=Rijndael_Cipher;
 	KeyTransfRounds=50000;
 	KeyError=false;
@@ -1861,7 +2215,11 @@ IEntryHandle* Kdb3Database::cloneEntry(const IEntryHandle* entry){
 	StdEntry dolly;
 	dolly=*((EntryHandle*)entry)->Entry;
 	dolly.Uuid.generate();
+	dolly.invalidateRecord();
 	Entries.append(dolly);
+	Entries.back().ListIndex=Entries.size()-1;
+	EntriesByUuid.insert(Entries.back().Uuid,&Entries.back());
+	attachEntry(&Entries.back(),Entries.back().Group);
 	EntryHandles.append(EntryHandle(this));
 	EntryHandles.back().Entry=&Entries.back();
 	Entries.back().Handle=&EntryHandles.back();
@@ -1872,8 +2230,10 @@ IEntryHandle* Kdb3Database::newEntry(IGroupHandle* group){
 	StdEntry Entry;
 	Entry.Uuid.generate();
 	Entry.Group=((GroupHandle*)group)->Group;
-	Entry.GroupId=Entry.Group->Id;
 	Entries.append(Entry);
+	Entries.back().ListIndex=Entries.size()-1;
+	EntriesByUuid.insert(Entries.back().Uuid,&Entries.back());
+	attachEntry(&Entries.back(),Entries.back().Group);
 	EntryHandles.append(EntryHandle(this));
 	EntryHandles.back().Entry=&Entries.back();
 	Entries.back().Handle=&EntryHandles.back();
@@ -1881,11 +2241,14 @@ IEntryHandle* Kdb3Database::newEntry(IGroupHandle* group){
 }
 
 IEntryHandle* Kdb3Database::addEntry(const CEntry* NewEntry, IGroupHandle* Group){
-	StdEntry Entry(*((StdEntry*)NewEntry));
+	StdEntry Entry;
+	*((CEntry*)&Entry)=*NewEntry;
 	Entry.Uuid.generate();
 	Entry.Group=((GroupHandle*)Group)->Group;
-	Entry.GroupId=Entry.Group->Id;
 	Entries.append(Entry);
+	Entries.back().ListIndex=Entries.size()-1;
+	EntriesByUuid.insert(Entries.back().Uuid,&Entries.back());
+	attachEntry(&Entries.back(),Entries.back().Group);
 	EntryHandles.append(EntryHandle(this));
 	EntryHandles.back().Entry=&Entries.back();
 	Entries.back().Handle=&EntryHandles.back();
@@ -1893,8 +2256,8 @@ IEntryHandle* Kdb3Database::addEntry(const CEntry* NewEntry, IGroupHandle* Group
 }
 
 void Kdb3Database::deleteLastEntry(){
-	Entries.removeAt(Entries.size()-1);
-	EntryHandles.back().invalidate();
+	// Entries.back() is not necessarily the last created entry, deleteEntry() reorders the list
+	deleteEntry(&EntryHandles.back());
 }
 
 bool Kdb3Database::isParent(IGroupHandle* parent, IGroupHandle* child){
@@ -1910,65 +2273,6 @@ bool Kdb3Database::isParent(IGroupHandle* parent, IGroupHandle* child){
 
 void Kdb3Database::cleanUpHandles(){}
 
-bool Kdb3Database::searchStringContains(const QString& search, const QString& string,bool Cs, bool RegExp){
-	if(RegExp){
-		QRegExp exp(search,Cs ? Qt::CaseSensitive : Qt::CaseInsensitive);
-		if(string.contains(exp)==0)return false;}
-		else
-			if(string.contains(search,Cs ? Qt::CaseSensitive : Qt::CaseInsensitive)==0)return false;
-
-		return true;
-}
-
-void Kdb3Database::getEntriesRecursive(IGroupHandle* Group, QList<IEntryHandle*>& EntryList){
-	EntryList<<entries(Group);
-	for(int i=0;i<((GroupHandle*)Group)->Group->Children.size();	i++){
-		getEntriesRecursive(((GroupHandle*)Group)->Group->Children[i]->Handle,EntryList);
-	}
-}
-
-QList<IEntryHandle*> Kdb3Database::search(IGroupHandle* Group,const QString& search, bool CaseSensitive, bool RegExp, bool Recursive,bool* Fields){
-	bool fields[6]={true,true,true,false,true,true};
-	if(!Fields)
-		Fields=fields;
-	QList<IEntryHandle*> SearchEntries;
-	if(search==QString())return Group ? entries(Group) : entries();
-	if(Group){
-		if(Recursive)
-			getEntriesRecursive(Group,SearchEntries);
-		else
-			SearchEntries=entries(Group);
-	}
-	else
-		SearchEntries=entries();
-	
-	IGroupHandle* bGroup = backupGroup();
-	
-	QList<IEntryHandle*> ResultEntries;
-	for(int i=0; i<SearchEntries.size(); i++){
-		IGroupHandle* entryGroup = SearchEntries[i]->group();
-		while (entryGroup->parent())
-			entryGroup = entryGroup->parent();
-		if (entryGroup == bGroup)
-			continue;
-		
-		bool match=false;
-		if(Fields[0])match=match||searchStringContains(search,SearchEntries[i]->title(),CaseSensitive,RegExp);
-		if(Fields[1])match=match||searchStringContains(search,SearchEntries[i]->username(),CaseSensitive,RegExp);
-		if(Fields[2])match=match||searchStringContains(search,SearchEntries[i]->url(),CaseSensitive,RegExp);
-		SecString Password=SearchEntries[i]->password();
-		Password.unlock();
-		if(Fields[3])match=match||searchStringContains(search,Password.string(),CaseSensitive,RegExp);
-		Password.lock();
-		if(Fields[4])match=match||searchStringContains(search,SearchEntries[i]->comment(),CaseSensitive,RegExp);
-		if(Fields[5])match=match||searchStringContains(search,SearchEntries[i]->binaryDesc(),CaseSensitive,RegExp);
-		if(match)
-			ResultEntries << SearchEntries[i];
-	}
-
-	return ResultEntries;
-}
-
 void Kdb3Database::rebuildIndices(QList<StdGroup*>& list){
 	for(int i=0;i<list.size();i++){
 		list[i]->Index=i;
@@ -1984,8 +2288,10 @@ void Kdb3Database::moveGroup(IGroupHandle* groupHandle,IGroupHandle* NewParent,i
 	else
 		Parent=&RootGroup;
 	Group->Parent->Children.removeAt(Group->Index);
+	Group->Parent->ChildrenSorted=false;
 	rebuildIndices(Group->Parent->Children);
 	Group->Parent=Parent;
+	Parent->ChildrenSorted=false;
 	if(Pos==-1){
 		Parent->Children.append(Group);
 	}
@@ -2051,70 +2357,208 @@ IDatabase* Kdb3Database::groupToNewDb(IGroupHandle* group){
 }*/
 
 
-void KeyTransform::transform(quint8* src, quint8* dst, quint8* KeySeed, int rounds){
-	KeyTransform* ktLeft = new KeyTransform(&src[0], &dst[0], KeySeed, rounds);
-	KeyTransform* ktRight = new KeyTransform(&src[16], &dst[16], KeySeed, rounds);
-	ktLeft->start();
-	ktRight->start();
-	ktLeft->wait();
-	ktRight->wait();
-	SHA256::hashBuffer(dst,dst,32);
-	delete ktLeft;
-	delete ktRight;
+class KeyTransformPool;
+
+//! Worker thread of the key transformation pool.
+class KeyTransformWorker : public QThread{
+	public:
+		KeyTransformWorker(KeyTransformPool* pool, int core) : Pool(pool), Core(core) {}
+	protected:
+		void run();
+	private:
+		KeyTransformPool* Pool;
+		int Core;
+};
+
+//! Queue of key transformation jobs which is processed by a fixed set of worker threads.
+class KeyTransformPool{
+	public:
+		//! One AES job: either one 16 byte half (Blocks==1) or a whole 32 byte key on the hardware AES path (Blocks==2).
+		struct Job{
+			const quint8* Src;
+			quint8* Dst;
+			int Blocks;
+			int Rounds;
+			const aes_encrypt_ctx* Ctx;
+			QSemaphore* Done;
+		};
+
+		KeyTransformPool();
+		~KeyTransformPool();
+		void runJobs(const QList<Job>& jobs);
+		bool takeJob(Job& job);
+		static void execute(const Job& job);
+
+	private:
+		QMutex Mutex;
+		QWaitCondition JobAvailable;
+		QQueue<Job> Jobs;
+		QList<KeyTransformWorker*> Workers;
+		bool Stopping;
+};
+
+Q_GLOBAL_STATIC(KeyTransformPool, keyTransformPool)
+
+KeyTransformPool::KeyTransformPool() : Stopping(false){
+	// the cores this process may run on, they might be less than the cores of the device
+	QList<int> cores;
+#ifdef Q_OS_LINUX
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if(sched_getaffinity(0, sizeof(allowed), &allowed) == 0){
+		for(int i=0; i<CPU_SETSIZE; i++){
+			if(CPU_ISSET(i, &allowed))
+				cores << i;
+		}
+	}
+#endif
+	// at least two workers, so that both halves of a key are always transformed in parallel
+	int count = qMax(2, cores.isEmpty() ? QThread::idealThreadCount() : cores.size());
+	for(int i=0; i<count; i++){
+		// workers are only pinned if there is more than one core to choose from
+		Workers << new KeyTransformWorker(this, cores.size() > 1 ? cores[i % cores.size()] : -1);
+		Workers.back()->start();
+	}
+}
+
+KeyTransformPool::~KeyTransformPool(){
+	Mutex.lock();
+	Stopping = true;
+	JobAvailable.wakeAll();
+	Mutex.unlock();
+	for(int i=0; i<Workers.size(); i++){
+		Workers[i]->wait();
+		delete Workers[i];
+	}
+}
+
+void KeyTransformPool::runJobs(const QList<Job>& jobs){
+	if(jobs.isEmpty()) return;
+	Mutex.lock();
+	for(int i=0; i<jobs.size(); i++)
+		Jobs.enqueue(jobs[i]);
+	JobAvailable.wakeAll();
+	Mutex.unlock();
+	// all jobs of one call share the same semaphore
+	jobs.first().Done->acquire(jobs.size());
 }
 
-KeyTransform::KeyTransform(quint8* pSrc, quint8* pDst, quint8* pKeySeed, int pRounds){
-	src = pSrc;
-	dst = pDst;
-	KeySeed = pKeySeed;
-	rounds = pRounds;
+bool KeyTransformPool::takeJob(Job& job){
+	QMutexLocker locker(&Mutex);
+	while(Jobs.isEmpty() && !Stopping)
+		JobAvailable.wait(&Mutex);
+	if(Stopping) return false;
+	job = Jobs.dequeue();
+	return true;
 }
 
-void KeyTransform::run(){
-	AESencrypt aes;
-	aes.key256(KeySeed);
-	memcpy(dst,src,16);
-	for (int i=0; i<rounds; i++){
-		aes.ecb_encrypt(dst,dst,16);
+void KeyTransformPool::execute(const Job& job){
+	if(job.Blocks == 2){
+		aes_hw_ecb_encrypt_2x(job.Src, job.Dst, job.Rounds, job.Ctx);
 	}
+	else{
+		memcpy(job.Dst, job.Src, 16);
+		for(int i=0; i<job.Rounds; i++)
+			aes_ecb_encrypt(job.Dst, job.Dst, 16, job.Ctx);
+	}
+	job.Done->release();
+}
+
+void KeyTransformWorker::run(){
+#ifdef Q_OS_LINUX
+	// pin every worker to its own core so that the halves do not compete for the same one
+	if(Core >= 0){
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(Core, &cpus);
+		// the worker still runs unpinned if this fails, e.g. if the core went offline meanwhile
+		int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		if(err != 0)
+			qDebug("KeyTransformWorker: could not pin thread to core %d (error %d)", Core, err);
+	}
+#endif
+	KeyTransformPool::Job job;
+	while(Pool->takeJob(job))
+		KeyTransformPool::execute(job);
+}
+
+//! Creates the worker threads ahead of time, so that this does not happen while unlocking a database.
+void KeyTransform::prepare(){
+	keyTransformPool();
+}
+
+void KeyTransform::transform(quint8* src, quint8* dst, quint8* KeySeed, int rounds){
+	QList<KeyTransformTask> tasks;
+	KeyTransformTask task = {src, dst};
+	tasks << task;
+	transform(tasks, KeySeed, rounds);
+}
+
+void KeyTransform::transform(const QList<KeyTransformTask>& tasks, quint8* KeySeed, int rounds){
+	aes_encrypt_ctx cx[1];
+	aes_init();
+	aes_encrypt_key256(KeySeed, cx);
+
+	// With hardware AES both halves are transformed interleaved in one job,
+	// which is faster than running them on two cores with the table based code
+	bool hw = aes_hw_available();
+	QSemaphore done;
+	QList<KeyTransformPool::Job> jobs;
+	for(int i=0; i<tasks.size(); i++){
+		KeyTransformPool::Job job = {tasks[i].src, tasks[i].dst, 2, rounds, cx, &done};
+		if(hw){
+			jobs << job;
+		}
+		else{
+			job.Blocks = 1;
+			jobs << job;
+			job.Src += 16;
+			job.Dst += 16;
+			jobs << job;
+		}
+	}
+	keyTransformPool()->runJobs(jobs);
+	memset(cx, 0, sizeof(cx));
+
+	for(int i=0; i<tasks.size(); i++)
+		SHA256::hashBuffer(tasks[i].dst, tasks[i].dst, 32);
 }
 
 
 int KeyTransformBenchmark::benchmark(int pMSecs){
-	KeyTransformBenchmark* ktbLeft = new KeyTransformBenchmark(pMSecs);
-	KeyTransformBenchmark* ktbRight = new KeyTransformBenchmark(pMSecs);
-	ktbLeft->start();
-	ktbRight->start();
-	ktbLeft->wait();
-	ktbRight->wait();
-	int num = std::min(ktbLeft->rounds, ktbRight->rounds);
-	delete ktbLeft;
-	delete ktbRight;
-	
-	return num;
+	qint64 rounds = roundsPerSecond()*pMSecs/1000;
+	return int(qBound<qint64>(1, rounds, 2147483647));
 }
 
-KeyTransformBenchmark::KeyTransformBenchmark(int pMSecs){
-	msecs = pMSecs;
-	rounds = 0;
+int KeyTransformBenchmark::transformTime(int rounds){
+	return int(qint64(rounds)*1000/roundsPerSecond());
 }
 
-void KeyTransformBenchmark::run(){
+qint64 KeyTransformBenchmark::roundsPerSecond(){
+	static QMutex mutex;
+	static qint64 cached = 0;
+	QMutexLocker locker(&mutex);
+	if(cached)
+		return cached;
+	
 	quint8 KeySeed[32];
 	memset(KeySeed, 0x4B, 32);
-	quint8 dst[16];
-	memset(dst, 0x7E, 16);
-	
-	QTime t;
-	t.start();
-	
-	AESencrypt aes;
-	aes.key256(KeySeed);
+	quint8 key[32];
+	memset(key, 0x7E, 32);
+	
+	// double the rounds until the measurement is long enough to be accurate
+	int rounds = 1024;
+	qint64 nsecs;
+	QElapsedTimer t;
+	forever{
+		t.start();
+		KeyTransform::transform(key, key, KeySeed, rounds);
+		nsecs = t.nsecsElapsed();
+		if(nsecs >= 200000000 || rounds >= (1 << 30))
+			break;
+		rounds *= 2;
+	}
 	
-	do {
-		for (int i=0; i<64; i++){
-			aes.ecb_encrypt(dst,dst,16);
-		}
-		rounds += 64;
-	} while (t.elapsed() < msecs);
+	cached = qMax<qint64>(1, qint64(rounds)*1000000000/qMax<qint64>(1, nsecs));
+	return cached;
 }
@@ -22,6 +22,8 @@
 
 #include <QThread>
 #include <QMap>
+#include <QHash>
+#include <QElapsedTimer>
 #include "database/Database_keepassx1.h"
 #include "config/keepassx.h"
 
@@ -108,6 +110,7 @@ public:
 			virtual int level();
 			virtual bool expanded();
 			virtual void setExpanded(bool IsExpanded);
+			virtual int numEntries();
 		private:
 			void invalidate(){valid=false;}
 			bool valid;
@@ -122,8 +125,19 @@ public:
 		public:
 				StdEntry();
 				quint16 Index;
+				//! Position in Kdb3Database::Entries, only a hint which is checked before it is used.
+				int ListIndex;
 				EntryHandle* Handle;
 				StdGroup* Group;
+				//! Serialized fields of the entry from the last save, empty if the entry was changed since then.
+				/*! The password field is not part of it, it is inserted at RecordPasswordPos when saving.
+				    The attachment and the end marker are not part of it either, they are appended when saving. */
+				QByteArray Record;
+				int RecordPasswordPos;
+				void invalidateRecord(){Record.clear();}
+				//! Case folded title and username for sorting, empty if it needs to be computed again.
+				QString SortKey;
+				void invalidateSortKey();
 	};
 
 	class StdGroup:public CGroup{
@@ -134,7 +148,17 @@ public:
 			StdGroup* Parent;
 			GroupHandle* Handle;
 			QList<StdGroup*> Children;
+			//! Entries of the group ordered by their index, Entries[i]->Index is always i.
 			QList<StdEntry*> Entries;
+			//! Case folded title for sorting, empty if it needs to be computed again.
+			QString SortKey;
+			//! Alphabetically sorted Children and Entries, only valid if the corresponding flag is set.
+			/*! The flags are reset when a child is added or removed or when a title changes. */
+			QList<StdGroup*> SortedChildren;
+			QList<StdEntry*> SortedEntries;
+			bool ChildrenSorted;
+			bool EntriesSorted;
+			void invalidateSortKey();
 	};
 
 	Kdb3Database();
@@ -155,7 +179,6 @@ public:
 	virtual void removeIcon(int index);
 	virtual void replaceIcon(int index,const QPixmap& icon);
 	virtual int builtinIcons(){return BUILTIN_ICONS;};
-	virtual QList<IEntryHandle*> search(IGroupHandle* Group,const QString& SearchString, bool CaseSensitve, bool RegExp,bool Recursive,bool* Fields);
 	virtual QFile* file(){return File;}
 	virtual bool changeFile(const QString& filename);
 	virtual void setCryptAlgorithm(CryptAlgorithm algo){Algorithm=algo;}
@@ -183,6 +206,8 @@ public:
 
 	virtual QList<IGroupHandle*> groups();
 	virtual QList<IGroupHandle*> sortedGroups();
+	//! Returns the direct subgroups of a group sorted by title, the order is cached per group.
+	QList<IGroupHandle*> sortedChildren(IGroupHandle* Group);
 	virtual void deleteGroup(IGroupHandle* group);
 	virtual void moveGroup(IGroupHandle* Group,IGroupHandle* NewParent,int Position);
 	virtual IGroupHandle* addGroup(const CGroup* Group,IGroupHandle* Parent);
@@ -193,9 +218,28 @@ public:
 	//virtual IDatabase* groupToNewDb(IGroupHandle* group);
 	
 	inline bool hasPasswordEncodingChanged() { return passwordEncodingChanged; };
+	inline bool isReadOnly() { return openedReadOnly; };
+	//! If enabled the keys for all password encodings are checked concurrently when loading a database.
+	/*! The content is decrypted in chunks of 256 KiB, so this needs one additional 256 KiB buffer per encoding. Enabled by default. */
+	inline void setSpeculativeDecryption(bool enabled) { SpeculativeDecryption = enabled; };
+	//! Duration and number of processed bytes of one stage of load() or save().
+	struct Stage{
+		const char* Name;
+		qint64 NSecs;
+		qint64 Bytes;
+	};
+	//! If enabled load() and save() measure how long each of their stages takes, see stages().
+	/*! Disabled by default, then nothing is measured. */
+	inline void setStageTiming(bool enabled) { StageTiming = enabled; };
+	//! Returns the stages of the last load() or save() if stage timing is enabled.
+	inline const QList<Stage>& stages() { return Stages; };
 
 private:
-	bool loadReal(QString filename, bool readOnly, bool differentEncoding);
+	struct DecryptCandidate;
+	struct ReadState;
+	bool loadReal(QString filename, bool readOnly);
+	void readContent(DecryptCandidate* Candidates, int NumCandidates, ReadState& State);
+	void readFields(ReadState& State);
 	QDateTime dateFromPackedStruct5(const unsigned char* pBytes);
 	void dateToPackedStruct5(const QDateTime& datetime, unsigned char* dst);
 	bool isMetaStream(StdEntry& Entry);
@@ -209,24 +253,32 @@ private:
 	bool readGroupField(StdGroup* group,QList<quint32>& Levels,quint16 FieldType, quint8 *pData);
 	bool createGroupTree(QList<quint32>& Levels);
 	void createHandles();
+	void beginStages();
+	void endStage(const char* Name, qint64 Bytes=0);
 	void invalidateHandle(StdEntry* entry);
+	void attachEntry(StdEntry* entry, StdGroup* group);
+	void detachEntry(StdEntry* entry);
+	static void renumberEntries(StdGroup* group, int from);
 	bool convHexToBinaryKey(char* HexKey, char* dst);
 	quint32 getNewGroupId();
-	void serializeEntries(QList<StdEntry>& EntryList,char* buffer,unsigned int& pos);
-	void serializeGroups(char* buffer,unsigned int& pos);
+	void updateRecord(StdEntry& Entry);
+	void serializeEntry(StdEntry& Entry,QByteArray& buffer);
+	void serializeEntries(QList<StdEntry>& EntryList,QByteArray& buffer);
+	void serializeGroups(QByteArray& buffer);
 	void appendChildrenToGroupList(QList<StdGroup*>& list,StdGroup& group);
     void appendChildrenToGroupList(QList<IGroupHandle*>& list,StdGroup& group);
-    void appendChildrenToGroupListSorted(QList<IGroupHandle*>& list, IGroupHandle *group);
-    bool searchStringContains(const QString& search, const QString& string,bool Cs, bool RegExp);
-	void getEntriesRecursive(IGroupHandle* Group, QList<IEntryHandle*>& EntryList);
+    void appendChildrenToGroupListSorted(QList<IGroupHandle*>& list, StdGroup* group);
+	const QList<StdGroup*>& sortedChildren(StdGroup* group);
+	const QList<StdEntry*>& sortedEntries(StdGroup* group);
 	void rebuildIndices(QList<StdGroup*>& list);
 	void restoreGroupTreeState();
 	//void copyTree(Kdb3Database* db, GroupHandle* orgGroup, IGroupHandle* parent);
 	static bool EntryHandleLessThan(const IEntryHandle* This,const IEntryHandle* Other);
-	static bool EntryHandleLessThanStd(const IEntryHandle* This,const IEntryHandle* Other);
-    static bool GroupHandleLessThanStd(const IGroupHandle* This,const IGroupHandle* Other);
-    static bool StdEntryLessThan(const Kdb3Database::StdEntry& This,const Kdb3Database::StdEntry& Other);
+	static bool StdEntrySortKeyLessThan(const Kdb3Database::StdEntry* This,const Kdb3Database::StdEntry* Other);
+	static bool StdGroupSortKeyLessThan(const Kdb3Database::StdGroup* This,const Kdb3Database::StdGroup* Other);
+    static bool StdEntryLessThan(const Kdb3Database::StdEntry* This,const Kdb3Database::StdEntry* Other);
 
+	void removeFromEntryIndex(StdEntry* entry);
 	StdEntry* getEntry(const KpxUuid& uuid);
 	StdEntry* getEntry(EntryHandle* handle);
 	int getEntryListIndex(EntryHandle* handle);
@@ -239,6 +291,9 @@ private:
 	QList<GroupHandle> GroupHandles;
 	QList<StdEntry> Entries;
 	QList<StdGroup> Groups;
+	//! Lookup tables for getEntry() and getGroup(), maintained on every add and delete.
+	QHash<KpxUuid,StdEntry*> EntriesByUuid;
+	QHash<quint32,StdGroup*> GroupsById;
 	StdGroup RootGroup;
 	QList<QPixmap>CustomIcons;
 	QFile* File;
@@ -259,38 +314,48 @@ private:
 	quint8 TransfRandomSeed[32];
 	bool hasV4IconMetaStream;
 	bool passwordEncodingChanged;
+	bool SpeculativeDecryption;
+	//! Reused by save(), it only holds encrypted data after a save.
+	QByteArray SaveBuffer;
+	bool StageTiming;
+	QList<Stage> Stages;
+	QElapsedTimer StageClock;
 };
 
-class KeyTransform : public QThread{
-	Q_OBJECT
-	
+//! One raw master key for KeyTransform::transform(), src and dst are 32 bytes long.
+struct KeyTransformTask{
+	quint8* src;
+	quint8* dst;
+};
+
+//! Master key transformation running on a persistent pool of worker threads.
+/*!
+  The worker threads are created once (see prepare()) and pinned to distinct
+  CPU cores, so that no thread creation or teardown happens while a database
+  is being unlocked. The left and right half of a key are transformed on
+  different workers, several keys can be transformed concurrently.
+*/
+class KeyTransform{
 	public:
+		static void prepare();
 		static void transform(quint8* src, quint8* dst, quint8* KeySeed, int rounds);
-	
-	private:
-		KeyTransform(quint8* pSrc, quint8* pDst, quint8* pKeySeed, int pRounds);
-		quint8* src;
-		quint8* dst;
-		quint8* KeySeed;
-		int rounds;
-	
-	protected:
-		void run();
+		static void transform(const QList<KeyTransformTask>& tasks, quint8* KeySeed, int rounds);
 };
 
-class KeyTransformBenchmark : public QThread{
-	Q_OBJECT
-	
+//! Measures the speed of the master key transformation on this device.
+/*!
+  The measurement uses KeyTransform, so it covers the worker pool and the
+  hardware AES path if the CPU supports it. It is done once and cached.
+*/
+class KeyTransformBenchmark{
 	public:
+		//! Returns the number of rounds which take about pMSecs milliseconds to transform.
 		static int benchmark(int pMSecs);
+		//! Returns the predicted time in milliseconds to transform a key with the given rounds.
+		static int transformTime(int rounds);
 	
 	private:
-		KeyTransformBenchmark(int pMSecs);
-		int msecs;
-		int rounds;
-	
-	protected:
-		void run();
+		static qint64 roundsPerSecond();
 };
 
 #endif
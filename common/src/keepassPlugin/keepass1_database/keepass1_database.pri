@@ -20,7 +20,7 @@
 #**
 #***************************************************************************
 
-QT += xml gui
+QT += xml gui concurrent
 
 INCLUDEPATH += $$PWD
 DEPENDPATH  += $$PWD
@@ -34,10 +34,12 @@ SOURCES += \
     ../common/src/keepassPlugin/keepass1_database/crypto/aescrypt.c \
     ../common/src/keepassPlugin/keepass1_database/crypto/aeskey.c \
     ../common/src/keepassPlugin/keepass1_database/crypto/aes_modes.c \
+    ../common/src/keepassPlugin/keepass1_database/crypto/aes_hw.c \
     ../common/src/keepassPlugin/keepass1_database/crypto/aestab.c \
     ../common/src/keepassPlugin/keepass1_database/crypto/arcfour.cpp \
     ../common/src/keepassPlugin/keepass1_database/crypto/blowfish.cpp \
     ../common/src/keepassPlugin/keepass1_database/crypto/sha256.cpp \
+    ../common/src/keepassPlugin/keepass1_database/crypto/sha256_hw.c \
     ../common/src/keepassPlugin/keepass1_database/crypto/twoclass.cpp \
     ../common/src/keepassPlugin/keepass1_database/crypto/twofish.cpp \
     ../common/src/keepassPlugin/keepass1_database/crypto/yarrow.cpp \
@@ -56,9 +58,11 @@ HEADERS += \
     ../common/src/keepassPlugin/keepass1_database/crypto/aes_types.h \
     ../common/src/keepassPlugin/keepass1_database/crypto/aesopt.h \
     ../common/src/keepassPlugin/keepass1_database/crypto/aestab.h \
+    ../common/src/keepassPlugin/keepass1_database/crypto/aes_hw.h \
     ../common/src/keepassPlugin/keepass1_database/crypto/arcfour.h \
     ../common/src/keepassPlugin/keepass1_database/crypto/blowfish.h \
     ../common/src/keepassPlugin/keepass1_database/crypto/sha256.h \
+    ../common/src/keepassPlugin/keepass1_database/crypto/sha256_hw.h \
     ../common/src/keepassPlugin/keepass1_database/crypto/twoclass.h \
     ../common/src/keepassPlugin/keepass1_database/crypto/twofish.h \
     ../common/src/keepassPlugin/keepass1_database/crypto/yarrow.h \
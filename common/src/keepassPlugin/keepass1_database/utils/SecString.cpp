@@ -60,6 +60,12 @@ void SecString::unlock(){
 	delete [] buffer;
 }
 
+void SecString::copyUtf8(char* dst){
+	if(!crypt.length())
+		return;
+	RC4.decrypt((const quint8*)crypt.constData(), (quint8*)dst, crypt.length());
+}
+
 const QString& SecString::string(){
 	Q_ASSERT_X(!locked, "SecString::string()", "string is locked");
 	return plain;
@@ -50,7 +50,11 @@ public:
 	void unlock();
 	const QString& string();
 	operator QString();
+	//! Returns the length of the UTF-8 encoded content in bytes.
 	int length();
+	/*! Decrypts the UTF-8 encoded content directly into dst without unlocking the SecString.
+		\param dst Buffer with space for length() bytes. */
+	void copyUtf8(char* dst);
 	
 	static void overwrite(unsigned char* str,int len);
 	static void overwrite(QString& str);
@@ -56,6 +56,8 @@ SOURCES += \
 \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2Reader.cpp \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2XmlReader.cpp \
+    ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2Writer.cpp \
+    ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2XmlWriter.cpp \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2RandomStream.cpp \
 \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/streams/StoreDataStream.cpp \
@@ -104,6 +106,8 @@ HEADERS += \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2.h \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2Reader.h \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2XmlReader.h \
+    ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2Writer.h \
+    ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2XmlWriter.h \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/format/KeePass2RandomStream.h \
 \
     ../common/src/keepassPlugin/keepass2_database/keepassx/src/streams/StoreDataStream.h \
@@ -65,6 +65,7 @@ public:
         RE_ERR_SEARCH,                              // search group is invalid
         RE_ERR_REMOVE_RECENT_DATABASE,              // Could not remove database from recent database list in the settings
         RE_ERR_DELETE_DATABASE,                     // Could not delete the database file from the file system
+        RE_ERR_ITEM_NOT_FOUND,                      // group or entry ID does not refer to an existing item (anymore)
 
 
         // Keepass 1 specific